@@ -5,8 +5,8 @@
 
 typedef void *(*gl_load_function)(const char* proc);
 
-#include <gl/gl.h>
-#include <gl/glext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
 
 #define GL_FUNC(name, NAME) PFN##NAME##PROC name
 
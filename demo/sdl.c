@@ -208,6 +208,17 @@ static bool SDL2_CollectEvents(void)
                 return false;
             } break;
 
+            case SDL_KEYDOWN:
+            {
+                // F12 saves what a Vulkan window shows.
+                SDL_Window *Window = SDL_GetWindowFromID(Event.key.windowID);
+                if (Event.key.keysym.sym == SDLK_F12 && Window && (SDL_GetWindowFlags(Window) & SDL_WINDOW_VULKAN))
+                {
+                    sdl2_vk *VK = SDL_GetWindowData(Window, "vulkan");
+                    VK->VK.Screenshot = true;
+                }
+            } break;
+
             case SDL_WINDOWEVENT:
             {
                 switch (Event.window.event)
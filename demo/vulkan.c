@@ -3,6 +3,8 @@
 
 #include "vk_funcs.h"
 #include "vk_utils.h"
+#include "readback.h"
+#include "convert.h"
 
 typedef struct vk_state vk_state;
 typedef void (*vk_log_func)(const char *);
@@ -24,6 +26,7 @@ typedef struct vk_swap_chain
     uint32_t ImageCount;
     VkImage *Images;
     VkExtent2D Extent;
+    VkFormat Format;
     VkSwapchainKHR Handle;
 } vk_swap_chain;
 
@@ -32,6 +35,9 @@ typedef struct vk_state
     vk_swap_chain SwapChain;
     shared_texture SharedTexture;
     vk_shared_texture VkSharedTexture;
+    vk_shared_copy Copy;
+    vk_shared_readback Readback;
+    bool Screenshot;
 
     // Instance
     VkInstance Instance;
@@ -194,6 +200,14 @@ static bool Vulkan_InitInstance(vk_state *VK, VkInstance Instance, VkSurfaceKHR
             .pEnabledFeatures = &(VkPhysicalDeviceFeatures){
                 .samplerAnisotropy = VK_TRUE
             },
+            .pNext = &(VkPhysicalDeviceVulkan13Features){
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+                .synchronization2 = VK_TRUE,
+                .pNext = &(VkPhysicalDeviceVulkan12Features){
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                    .timelineSemaphore = VK_TRUE
+                },
+            },
         },
         0, &VK->Device
     );
@@ -263,6 +277,7 @@ static bool Vulkan_CreateSwapChain(vk_state *VK)
     if (Result != VK_SUCCESS)
         return false;
 
+    VK->SwapChain.Format = SurfaceFormat.format;
     vkGetSwapchainImagesKHR(VK->Device, VK->SwapChain.Handle, &VK->SwapChain.ImageCount, 0);
     VK->SwapChain.Images = malloc(sizeof(VkImage) * VK->SwapChain.ImageCount);
     vkGetSwapchainImagesKHR(VK->Device, VK->SwapChain.Handle, &VK->SwapChain.ImageCount, VK->SwapChain.Images);
@@ -270,8 +285,10 @@ static bool Vulkan_CreateSwapChain(vk_state *VK)
     return true;
 }
 
+// Callers wait for the device first, the copies into the images are idle then.
 static void Vulkan_DestroySwapChain(vk_state *VK)
 {
+    SharedTexture_InvalidateVulkanCopy(&VK->Copy, VK_NULL_HANDLE);
     vkDestroySwapchainKHR(VK->Device, VK->SwapChain.Handle, 0);
     free(VK->SwapChain.Images);
     VK->SwapChain = (vk_swap_chain){ 0 };
@@ -350,10 +367,39 @@ static void Vulkan_DestroySyncObjects(vk_state *VK)
     vkDestroySemaphore(VK->Device, VK->SwapChainSemaphore, 0);
 }
 
+// Writes the frame read back for a screenshot as a TGA image, which stores
+// BGRA rows bottom up.
+static void Vulkan_SaveScreenshot(void *UserData, const uint8_t *Data, uint64_t RowPitch, int64_t Frame)
+{
+    vk_state *VK = UserData;
+    int32_t Width = VK->Readback.Width;
+    int32_t Height = VK->Readback.Height;
+    uint8_t *Pixels = malloc((size_t)Width * Height * 4);
+    FILE *File = Pixels ? fopen("screenshot.tga", "wb") : 0;
+    if (!File)
+    {
+        free(Pixels);
+        return;
+    }
+    SharedConvert_SwizzleRB(Pixels, (int64_t)Width * 4, Data + (Height - 1) * RowPitch, -(int64_t)RowPitch, Width, Height);
+
+    const uint8_t Header[18] = {
+        [2] = 2, // uncompressed true color
+        [12] = Width & 0xFF, [13] = Width >> 8,
+        [14] = Height & 0xFF, [15] = Height >> 8,
+        [16] = 32, [17] = 8, // 8 alpha bits, origin bottom left
+    };
+    fwrite(Header, 1, sizeof(Header), File);
+    fwrite(Pixels, 4, (size_t)Width * Height, File);
+    fclose(File);
+    free(Pixels);
+}
+
 static bool Vulkan_Init(vk_state *VK)
 {
     if (!Vulkan_InitCommandBuffers(VK) ||
-        !Vulkan_CreateSyncObjects(VK))
+        !Vulkan_CreateSyncObjects(VK) ||
+        !SharedTexture_CreateVulkanCopy(&VK->Copy, VK->Device, Vulkan_DefaultQueueFamilyIndex(VK->PhysicalDevice, VK->Surface)))
     {
         Vulkan_Destroy(VK);
         return false;
@@ -362,6 +408,10 @@ static bool Vulkan_Init(vk_state *VK)
     VK->SharedTexture = SharedTexture_OpenOrCreate("demo", 1280, 720, SHARED_TEXTURE_RGBA8);
     VK->VkSharedTexture = SharedTexture_ToVulkan(VK->SharedTexture, VK->Device, VK->PhysicalDevice);
 
+    // Screenshots are optional, the demo runs without them.
+    SharedReadback_CreateVulkan(&VK->Readback, VK->SharedTexture, 2, Vulkan_SaveScreenshot, VK,
+        VK->Device, VK->PhysicalDevice, Vulkan_DefaultQueueFamilyIndex(VK->PhysicalDevice, VK->Surface));
+
     return true;
 }
 
@@ -369,9 +419,11 @@ static void Vulkan_Destroy(vk_state *VK)
 {
     vkDeviceWaitIdle(VK->Device);
 
+    SharedReadback_DestroyVulkan(&VK->Readback);
     SharedTexture_DestroyVulkanTexture(VK->VkSharedTexture, VK->Device);
     SharedTexture_Close(VK->SharedTexture);
 
+    SharedTexture_DestroyVulkanCopy(&VK->Copy);
     Vulkan_DestroyCommandBuffers(VK);
     Vulkan_DestroySyncObjects(VK);
     Vulkan_DestroySwapChain(VK);
@@ -394,6 +446,17 @@ static void Vulkan_Update(vk_state *VK, int32_t Width, int32_t Height, float Del
         return;
     }
 
+    // SCREENSHOT
+    // The readback submit waits on and signals the shared semaphore ahead of the blit below.
+    if (VK->Screenshot && VK->Readback.SlotCount)
+    {
+        if (SharedReadback_VulkanRead(&VK->Readback, VK->VkSharedTexture, VK->Queue,
+                                      SharedTexture_VulkanLayout(VK->SharedTexture), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL))
+            SharedTexture_StoreLayout(VK->SharedTexture, SHARED_TEXTURE_LAYOUT_TRANSFER_SRC);
+    }
+    VK->Screenshot = false;
+    SharedReadback_VulkanPoll(&VK->Readback);
+
     vkResetCommandBuffer(VK->CommandBuffer, 0);
     vkBeginCommandBuffer(VK->CommandBuffer,
         &(VkCommandBufferBeginInfo) {
@@ -404,145 +467,9 @@ static void Vulkan_Update(vk_state *VK, int32_t Width, int32_t Height, float Del
     );
 
     // BLIT
-    vkCmdPipelineBarrier(VK->CommandBuffer,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        0,
-        0, (VkMemoryBarrier[]) { 0 },
-        0, (VkBufferMemoryBarrier[]) { 0 },
-        1, (VkImageMemoryBarrier[]) {
-            {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_NONE,
-                .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
-                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                .image = VK->VkSharedTexture.Image,
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-            }
-        }
-    );
-
-    vkCmdPipelineBarrier(VK->CommandBuffer,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        0,
-        0, (VkMemoryBarrier[]) { 0 },
-        0, (VkBufferMemoryBarrier[]) { 0 },
-        1, (VkImageMemoryBarrier[]) {
-            {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_NONE,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .image = VK->SwapChain.Images[CurrentSwapChainImage],
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-            }
-        }
-    );
-
-    vkCmdBlitImage(VK->CommandBuffer,
-        VK->VkSharedTexture.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        VK->SwapChain.Images[CurrentSwapChainImage], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1, (VkImageBlit[]) {
-            {
-                .srcSubresource = (VkImageSubresourceLayers) {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .mipLevel = 0,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-                .srcOffsets = {
-                    [0] = {
-                        .x = 0,
-                        .y = VK->SharedTexture.Height,
-                        .z = 0
-                    },
-                    [1] = {
-                        .x = VK->SharedTexture.Width,
-                        .y = 0,
-                        .z = 1
-                    }
-                },
-                .dstSubresource = (VkImageSubresourceLayers) {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .mipLevel = 0,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-                .dstOffsets = {
-                    [1] = {
-                        .x = VK->SwapChain.Extent.width,
-                        .y = VK->SwapChain.Extent.height,
-                        .z = 1,
-                    }
-                }
-            }
-        },
-        VK_FILTER_NEAREST);
-
-    vkCmdPipelineBarrier(VK->CommandBuffer,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-        0,
-        0, (VkMemoryBarrier[]) { 0 },
-        0, (VkBufferMemoryBarrier[]) { 0 },
-        1, (VkImageMemoryBarrier[]) {
-            {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_NONE,
-                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                .newLayout = VK_IMAGE_LAYOUT_GENERAL,
-                .image = VK->VkSharedTexture.Image,
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-            }
-        }
-    );
-
-    vkCmdPipelineBarrier(VK->CommandBuffer,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-        0,
-        0, (VkMemoryBarrier[]) { 0 },
-        0, (VkBufferMemoryBarrier[]) { 0 },
-        1, (VkImageMemoryBarrier[]) {
-            {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_NONE,
-                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                .image = VK->SwapChain.Images[CurrentSwapChainImage],
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0,
-                    .levelCount = 1,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-            }
-        }
-    );
+    bool Copied = SharedTexture_VulkanRecordCopy(&VK->Copy, VK->CommandBuffer, VK->SharedTexture, VK->VkSharedTexture,
+        VK->SwapChain.Images[CurrentSwapChainImage], VK->SwapChain.Format, VK->SwapChain.Extent.width, VK->SwapChain.Extent.height,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, true);
 
     vkEndCommandBuffer(VK->CommandBuffer);
 
@@ -563,6 +490,8 @@ static void Vulkan_Update(vk_state *VK, int32_t Width, int32_t Height, float Del
     );
     if (SubmitResult != VK_SUCCESS)
         return;
+    if (Copied)
+        SharedTexture_StoreLayout(VK->SharedTexture, SharedTexture_FromVulkanLayout(VK->Copy.Layout));
     
     VkResult PresentResult = vkQueuePresentKHR(VK->Queue,
         &(VkPresentInfoKHR) {
@@ -0,0 +1,749 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+#include "convert.h"
+
+#include <math.h>
+
+// Every conversion is a row kernel over Count channels, SIMD kernels do whole
+// vectors and leave the remainder to the scalar one. Kernels without a SIMD
+// version at a level fall back to the scalar or table based one.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define CONVERT_X86 1
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #define CONVERT_SSE2
+    #define CONVERT_AVX2
+  #else
+    #include <cpuid.h>
+    #define CONVERT_SSE2 __attribute__((target("sse2")))
+    #define CONVERT_AVX2 __attribute__((target("avx2,f16c")))
+  #endif
+#elif defined(__aarch64__)
+  // MSVC has no float16x4_t, ARM64 builds of it stay on the scalar kernels.
+  #define CONVERT_NEON 1
+  #include <arm_neon.h>
+#endif
+
+typedef void shared_convert_row(void *Dst, const void *Src, int32_t Count, const float *Params);
+
+static struct
+{
+    uint32_t Supported;             // bit per shared_convert_level
+    uint32_t Level;
+    float SrgbToLinear[512];        // sRGB bytes, then alpha bytes
+    int32_t LinearToSrgb[4096];     // [0, 1] in steps of 1 / 4095
+} Convert;
+
+//
+// SCALAR
+//
+
+static uint8_t SharedConvert_ToUnorm(float Value)
+{
+    Value = Value > 0.0f ? Value : 0.0f;    // NaN too
+    Value = Value < 1.0f ? Value : 1.0f;
+    return (uint8_t)(Value * 255.0f + 0.5f);
+}
+
+static float SharedConvert_EncodeSrgb(float Linear)
+{
+    return Linear <= 0.0031308f ? Linear * 12.92f : 1.055f * powf(Linear, 1.0f / 2.4f) - 0.055f;
+}
+
+static float SharedConvert_DecodeSrgb(float Srgb)
+{
+    return Srgb <= 0.04045f ? Srgb / 12.92f : powf((Srgb + 0.055f) / 1.055f, 2.4f);
+}
+
+// Round to nearest even, see F. Giesen, "float->half variants".
+static uint16_t SharedConvert_ToHalf(float Value)
+{
+    union { float F; uint32_t U; } Bits = { Value };
+    const union { float F; uint32_t U; } DenormMagic = { .U = ((127 - 15) + (23 - 10) + 1) << 23 };
+    uint32_t Sign = Bits.U & 0x80000000u;
+    Bits.U ^= Sign;
+
+    uint16_t Half;
+    if (Bits.U >= (127 + 16) << 23)
+        Half = Bits.U > 255u << 23 ? 0x7E00 : 0x7C00;
+    else if (Bits.U < (127 - 14) << 23)
+    {
+        Bits.F += DenormMagic.F;
+        Half = (uint16_t)(Bits.U - DenormMagic.U);
+    }
+    else
+    {
+        uint32_t MantissaOdd = (Bits.U >> 13) & 1;
+        Bits.U += ((uint32_t)(15 - 127) << 23) + 0xFFF + MantissaOdd;
+        Half = (uint16_t)(Bits.U >> 13);
+    }
+    return Half | (uint16_t)(Sign >> 16);
+}
+
+static float SharedConvert_FromHalf(uint16_t Half)
+{
+    const union { float F; uint32_t U; } Magic = { .U = (254 - 15) << 23 };
+    union { float F; uint32_t U; } Bits = { .U = (uint32_t)(Half & 0x7FFF) << 13 };
+    Bits.F *= Magic.F;
+    if ((Half & 0x7FFF) > 0x7BFF)
+        Bits.U |= 255u << 23;
+    Bits.U |= (uint32_t)(Half & 0x8000) << 16;
+    return Bits.F;
+}
+
+static void SharedConvert_SwizzleRBScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const uint8_t *S = Src;
+    for (int32_t i = 0; i < Count; i += 4)
+    {
+        uint8_t R = S[i + 0], G = S[i + 1], B = S[i + 2], A = S[i + 3];
+        D[i + 0] = B;
+        D[i + 1] = G;
+        D[i + 2] = R;
+        D[i + 3] = A;
+    }
+}
+
+static void SharedConvert_UnormToFloatScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint8_t *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+        D[i] = (float)S[i] * (1.0f / 255.0f);
+}
+
+static void SharedConvert_FloatToUnormScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+        D[i] = SharedConvert_ToUnorm(S[i]);
+}
+
+static void SharedConvert_FloatToHalfScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint16_t *D = Dst;
+    const float *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+        D[i] = SharedConvert_ToHalf(S[i]);
+}
+
+static void SharedConvert_HalfToFloatScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint16_t *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+        D[i] = SharedConvert_FromHalf(S[i]);
+}
+
+// Count is a multiple of 4 for all RGBA kernels, so i & 3 is the channel.
+static void SharedConvert_SrgbToLinearScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint8_t *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+        D[i] = Convert.SrgbToLinear[S[i] + ((i & 3) == 3 ? 256 : 0)];
+}
+
+static void SharedConvert_LinearToSrgbScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+    {
+        float Value = S[i] > 0.0f ? S[i] : 0.0f;
+        Value = Value < 1.0f ? Value : 1.0f;
+        D[i] = SharedConvert_ToUnorm((i & 3) == 3 ? Value : SharedConvert_EncodeSrgb(Value));
+    }
+}
+
+static void SharedConvert_LinearToSrgbTable(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+    {
+        float Value = S[i] > 0.0f ? S[i] : 0.0f;
+        Value = Value < 1.0f ? Value : 1.0f;
+        D[i] = (i & 3) == 3 ? SharedConvert_ToUnorm(Value) : (uint8_t)Convert.LinearToSrgb[(int32_t)(Value * 4095.0f + 0.5f)];
+    }
+}
+
+// Params are Min and 1 / (Max - Min).
+static void SharedConvert_NormalizeDepthScalar(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const float *S = Src;
+    for (int32_t i = 0; i < Count; ++i)
+    {
+        float Value = (S[i] - Params[0]) * Params[1];
+        Value = Value > 0.0f ? Value : 0.0f;
+        D[i] = Value < 1.0f ? Value : 1.0f;
+    }
+}
+
+#if defined(CONVERT_X86)
+
+//
+// SSE2
+//
+
+CONVERT_SSE2 static void SharedConvert_SwizzleRBSse2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const uint8_t *S = Src;
+    const __m128i GA = _mm_set1_epi32((int32_t)0xFF00FF00);
+    int32_t i = 0;
+    for (; i + 16 <= Count; i += 16)
+    {
+        __m128i X = _mm_loadu_si128((const __m128i *)(S + i));
+        __m128i RB = _mm_andnot_si128(GA, X);
+        RB = _mm_or_si128(_mm_slli_epi32(RB, 16), _mm_srli_epi32(RB, 16));
+        _mm_storeu_si128((__m128i *)(D + i), _mm_or_si128(_mm_and_si128(X, GA), RB));
+    }
+    SharedConvert_SwizzleRBScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_SSE2 static void SharedConvert_UnormToFloatSse2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint8_t *S = Src;
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128 Scale = _mm_set1_ps(1.0f / 255.0f);
+    int32_t i = 0;
+    for (; i + 16 <= Count; i += 16)
+    {
+        __m128i X = _mm_loadu_si128((const __m128i *)(S + i));
+        __m128i Lo = _mm_unpacklo_epi8(X, Zero), Hi = _mm_unpackhi_epi8(X, Zero);
+        _mm_storeu_ps(D + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(Lo, Zero)), Scale));
+        _mm_storeu_ps(D + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(Lo, Zero)), Scale));
+        _mm_storeu_ps(D + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(Hi, Zero)), Scale));
+        _mm_storeu_ps(D + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(Hi, Zero)), Scale));
+    }
+    SharedConvert_UnormToFloatScalar(D + i, S + i, Count - i, Params);
+}
+
+// max returns its second operand for NaN, which turns NaN into 0 like the scalar kernel.
+CONVERT_SSE2 static __m128i SharedConvert_ToUnormSse2(__m128 X)
+{
+    X = _mm_min_ps(_mm_max_ps(X, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(X, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+CONVERT_SSE2 static void SharedConvert_FloatToUnormSse2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 16 <= Count; i += 16)
+    {
+        __m128i A = SharedConvert_ToUnormSse2(_mm_loadu_ps(S + i + 0));
+        __m128i B = SharedConvert_ToUnormSse2(_mm_loadu_ps(S + i + 4));
+        __m128i C = SharedConvert_ToUnormSse2(_mm_loadu_ps(S + i + 8));
+        __m128i E = SharedConvert_ToUnormSse2(_mm_loadu_ps(S + i + 12));
+        _mm_storeu_si128((__m128i *)(D + i), _mm_packus_epi16(_mm_packs_epi32(A, B), _mm_packs_epi32(C, E)));
+    }
+    SharedConvert_FloatToUnormScalar(D + i, S + i, Count - i, Params);
+}
+
+// SharedConvert_ToHalf on four lanes. The sign is shifted in arithmetically
+// so a signed pack keeps the low 16 bits.
+CONVERT_SSE2 static __m128i SharedConvert_ToHalfSse2(__m128 X)
+{
+    const __m128i DenormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    __m128 Sign = _mm_and_ps(X, _mm_castsi128_ps(_mm_set1_epi32((int32_t)0x80000000u)));
+    __m128 Abs = _mm_xor_ps(X, Sign);
+    __m128i AbsBits = _mm_castps_si128(Abs);
+
+    __m128i IsNan = _mm_castps_si128(_mm_cmpunord_ps(Abs, Abs));
+    __m128i IsRegular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), AbsBits);
+    __m128i InfOrNan = _mm_or_si128(_mm_and_si128(IsNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+    __m128i IsDenorm = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), AbsBits);
+
+    __m128i Denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(Abs, _mm_castsi128_ps(DenormMagic))), DenormMagic);
+    __m128i MantissaOdd = _mm_srai_epi32(_mm_slli_epi32(AbsBits, 31 - 13), 31);
+    __m128i Rounded = _mm_sub_epi32(_mm_add_epi32(AbsBits, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), MantissaOdd);
+    __m128i Normal = _mm_srli_epi32(Rounded, 13);
+
+    __m128i Finite = _mm_or_si128(_mm_and_si128(IsDenorm, Denorm), _mm_andnot_si128(IsDenorm, Normal));
+    __m128i Joined = _mm_or_si128(_mm_and_si128(IsRegular, Finite), _mm_andnot_si128(IsRegular, InfOrNan));
+    return _mm_or_si128(Joined, _mm_srai_epi32(_mm_castps_si128(Sign), 16));
+}
+
+CONVERT_SSE2 static __m128 SharedConvert_FromHalfSse2(__m128i Half)
+{
+    __m128i Bits = _mm_and_si128(Half, _mm_set1_epi32(0x7FFF));
+    __m128i Sign = _mm_slli_epi32(_mm_xor_si128(Half, Bits), 16);
+    __m128 Scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(Bits, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    __m128i InfOrNan = _mm_and_si128(_mm_cmpgt_epi32(Bits, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+    return _mm_or_ps(Scaled, _mm_castsi128_ps(_mm_or_si128(Sign, InfOrNan)));
+}
+
+CONVERT_SSE2 static void SharedConvert_FloatToHalfSse2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint16_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+    {
+        __m128i Lo = SharedConvert_ToHalfSse2(_mm_loadu_ps(S + i + 0));
+        __m128i Hi = SharedConvert_ToHalfSse2(_mm_loadu_ps(S + i + 4));
+        _mm_storeu_si128((__m128i *)(D + i), _mm_packs_epi32(Lo, Hi));
+    }
+    SharedConvert_FloatToHalfScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_SSE2 static void SharedConvert_HalfToFloatSse2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint16_t *S = Src;
+    const __m128i Zero = _mm_setzero_si128();
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+    {
+        __m128i X = _mm_loadu_si128((const __m128i *)(S + i));
+        _mm_storeu_ps(D + i + 0, SharedConvert_FromHalfSse2(_mm_unpacklo_epi16(X, Zero)));
+        _mm_storeu_ps(D + i + 4, SharedConvert_FromHalfSse2(_mm_unpackhi_epi16(X, Zero)));
+    }
+    SharedConvert_HalfToFloatScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_SSE2 static void SharedConvert_NormalizeDepthSse2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const float *S = Src;
+    const __m128 Min = _mm_set1_ps(Params[0]), Scale = _mm_set1_ps(Params[1]);
+    const __m128 Zero = _mm_setzero_ps(), One = _mm_set1_ps(1.0f);
+    int32_t i = 0;
+    for (; i + 4 <= Count; i += 4)
+    {
+        __m128 X = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(S + i), Min), Scale);
+        _mm_storeu_ps(D + i, _mm_min_ps(_mm_max_ps(X, Zero), One));
+    }
+    SharedConvert_NormalizeDepthScalar(D + i, S + i, Count - i, Params);
+}
+
+//
+// AVX2
+//
+
+// Packs 32 values of 0 to 255 in lane order, undoing the per-lane packs.
+CONVERT_AVX2 static __m256i SharedConvert_PackUnormAvx2(__m256i A, __m256i B, __m256i C, __m256i D)
+{
+    __m256i Packed = _mm256_packus_epi16(_mm256_packs_epi32(A, B), _mm256_packs_epi32(C, D));
+    return _mm256_permutevar8x32_epi32(Packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+CONVERT_AVX2 static __m256i SharedConvert_ToUnormAvx2(__m256 X)
+{
+    X = _mm256_min_ps(_mm256_max_ps(X, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(X, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+CONVERT_AVX2 static void SharedConvert_SwizzleRBAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const uint8_t *S = Src;
+    const __m256i Shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int32_t i = 0;
+    for (; i + 32 <= Count; i += 32)
+        _mm256_storeu_si256((__m256i *)(D + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(S + i)), Shuffle));
+    SharedConvert_SwizzleRBScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static void SharedConvert_UnormToFloatAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint8_t *S = Src;
+    const __m256 Scale = _mm256_set1_ps(1.0f / 255.0f);
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+    {
+        __m256i X = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(S + i)));
+        _mm256_storeu_ps(D + i, _mm256_mul_ps(_mm256_cvtepi32_ps(X), Scale));
+    }
+    SharedConvert_UnormToFloatScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static void SharedConvert_FloatToUnormAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 32 <= Count; i += 32)
+    {
+        __m256i Packed = SharedConvert_PackUnormAvx2(SharedConvert_ToUnormAvx2(_mm256_loadu_ps(S + i + 0)),
+                                                     SharedConvert_ToUnormAvx2(_mm256_loadu_ps(S + i + 8)),
+                                                     SharedConvert_ToUnormAvx2(_mm256_loadu_ps(S + i + 16)),
+                                                     SharedConvert_ToUnormAvx2(_mm256_loadu_ps(S + i + 24)));
+        _mm256_storeu_si256((__m256i *)(D + i), Packed);
+    }
+    SharedConvert_FloatToUnormScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static void SharedConvert_FloatToHalfAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint16_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+        _mm_storeu_si128((__m128i *)(D + i), _mm256_cvtps_ph(_mm256_loadu_ps(S + i), _MM_FROUND_TO_NEAREST_INT));
+    SharedConvert_FloatToHalfScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static void SharedConvert_HalfToFloatAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint16_t *S = Src;
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+        _mm256_storeu_ps(D + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(S + i))));
+    SharedConvert_HalfToFloatScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static void SharedConvert_SrgbToLinearAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint8_t *S = Src;
+    const __m256i AlphaOffset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+    {
+        __m256i Index = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(S + i))), AlphaOffset);
+        _mm256_storeu_ps(D + i, _mm256_i32gather_ps(Convert.SrgbToLinear, Index, 4));
+    }
+    SharedConvert_SrgbToLinearScalar(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static __m256i SharedConvert_ToSrgbAvx2(__m256 X)
+{
+    const __m256i Alpha = _mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1);
+    X = _mm256_min_ps(_mm256_max_ps(X, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    __m256i Index = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(X, _mm256_set1_ps(4095.0f)), _mm256_set1_ps(0.5f)));
+    __m256i Color = _mm256_i32gather_epi32(Convert.LinearToSrgb, Index, 4);
+    return _mm256_blendv_epi8(Color, SharedConvert_ToUnormAvx2(X), Alpha);
+}
+
+CONVERT_AVX2 static void SharedConvert_LinearToSrgbAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 32 <= Count; i += 32)
+    {
+        __m256i Packed = SharedConvert_PackUnormAvx2(SharedConvert_ToSrgbAvx2(_mm256_loadu_ps(S + i + 0)),
+                                                     SharedConvert_ToSrgbAvx2(_mm256_loadu_ps(S + i + 8)),
+                                                     SharedConvert_ToSrgbAvx2(_mm256_loadu_ps(S + i + 16)),
+                                                     SharedConvert_ToSrgbAvx2(_mm256_loadu_ps(S + i + 24)));
+        _mm256_storeu_si256((__m256i *)(D + i), Packed);
+    }
+    SharedConvert_LinearToSrgbTable(D + i, S + i, Count - i, Params);
+}
+
+CONVERT_AVX2 static void SharedConvert_NormalizeDepthAvx2(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const float *S = Src;
+    const __m256 Min = _mm256_set1_ps(Params[0]), Scale = _mm256_set1_ps(Params[1]);
+    const __m256 Zero = _mm256_setzero_ps(), One = _mm256_set1_ps(1.0f);
+    int32_t i = 0;
+    for (; i + 8 <= Count; i += 8)
+    {
+        __m256 X = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(S + i), Min), Scale);
+        _mm256_storeu_ps(D + i, _mm256_min_ps(_mm256_max_ps(X, Zero), One));
+    }
+    SharedConvert_NormalizeDepthScalar(D + i, S + i, Count - i, Params);
+}
+
+static bool SharedConvert_HasAvx2(void)
+{
+    uint32_t Leaf1[4], Leaf7[4];
+#if defined(_MSC_VER)
+    __cpuid((int *)Leaf1, 1);
+    __cpuidex((int *)Leaf7, 7, 0);
+#else
+    if (!__get_cpuid(1, &Leaf1[0], &Leaf1[1], &Leaf1[2], &Leaf1[3]) ||
+        !__get_cpuid_count(7, 0, &Leaf7[0], &Leaf7[1], &Leaf7[2], &Leaf7[3]))
+        return false;
+#endif
+    bool Osxsave = Leaf1[2] & (1u << 27), F16c = Leaf1[2] & (1u << 29), Avx2 = Leaf7[1] & (1u << 5);
+    if (!Osxsave || !F16c || !Avx2)
+        return false;
+
+    // The OS has to save the YMM registers as well.
+#if defined(_MSC_VER)
+    uint64_t Xcr0 = _xgetbv(0);
+#else
+    uint32_t Lo, Hi;
+    __asm__("xgetbv" : "=a"(Lo), "=d"(Hi) : "c"(0));
+    uint64_t Xcr0 = ((uint64_t)Hi << 32) | Lo;
+#endif
+    return (Xcr0 & 6) == 6;
+}
+
+#endif // defined(CONVERT_X86)
+
+#if defined(CONVERT_NEON)
+
+//
+// NEON
+//
+
+static void SharedConvert_SwizzleRBNeon(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const uint8_t *S = Src;
+    int32_t i = 0;
+    for (; i + 64 <= Count; i += 64)
+    {
+        uint8x16x4_t X = vld4q_u8(S + i);
+        uint8x16_t R = X.val[0];
+        X.val[0] = X.val[2];
+        X.val[2] = R;
+        vst4q_u8(D + i, X);
+    }
+    SharedConvert_SwizzleRBScalar(D + i, S + i, Count - i, Params);
+}
+
+static void SharedConvert_UnormToFloatNeon(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint8_t *S = Src;
+    int32_t i = 0;
+    for (; i + 16 <= Count; i += 16)
+    {
+        uint8x16_t X = vld1q_u8(S + i);
+        uint16x8_t Lo = vmovl_u8(vget_low_u8(X)), Hi = vmovl_u8(vget_high_u8(X));
+        vst1q_f32(D + i + 0, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(Lo))), 1.0f / 255.0f));
+        vst1q_f32(D + i + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(Lo))), 1.0f / 255.0f));
+        vst1q_f32(D + i + 8, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(Hi))), 1.0f / 255.0f));
+        vst1q_f32(D + i + 12, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(Hi))), 1.0f / 255.0f));
+    }
+    SharedConvert_UnormToFloatScalar(D + i, S + i, Count - i, Params);
+}
+
+// maxnm returns the number for NaN, which turns NaN into 0 like the scalar kernel.
+static uint16x4_t SharedConvert_ToUnormNeon(float32x4_t X)
+{
+    X = vminnmq_f32(vmaxnmq_f32(X, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    return vmovn_u32(vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(X, 255.0f), vdupq_n_f32(0.5f))));
+}
+
+static void SharedConvert_FloatToUnormNeon(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint8_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 16 <= Count; i += 16)
+    {
+        uint8x8_t Lo = vmovn_u16(vcombine_u16(SharedConvert_ToUnormNeon(vld1q_f32(S + i + 0)), SharedConvert_ToUnormNeon(vld1q_f32(S + i + 4))));
+        uint8x8_t Hi = vmovn_u16(vcombine_u16(SharedConvert_ToUnormNeon(vld1q_f32(S + i + 8)), SharedConvert_ToUnormNeon(vld1q_f32(S + i + 12))));
+        vst1q_u8(D + i, vcombine_u8(Lo, Hi));
+    }
+    SharedConvert_FloatToUnormScalar(D + i, S + i, Count - i, Params);
+}
+
+static void SharedConvert_FloatToHalfNeon(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    uint16_t *D = Dst;
+    const float *S = Src;
+    int32_t i = 0;
+    for (; i + 4 <= Count; i += 4)
+        vst1_u16(D + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(S + i))));
+    SharedConvert_FloatToHalfScalar(D + i, S + i, Count - i, Params);
+}
+
+static void SharedConvert_HalfToFloatNeon(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const uint16_t *S = Src;
+    int32_t i = 0;
+    for (; i + 4 <= Count; i += 4)
+        vst1q_f32(D + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(S + i))));
+    SharedConvert_HalfToFloatScalar(D + i, S + i, Count - i, Params);
+}
+
+static void SharedConvert_NormalizeDepthNeon(void *Dst, const void *Src, int32_t Count, const float *Params)
+{
+    float *D = Dst;
+    const float *S = Src;
+    const float32x4_t Min = vdupq_n_f32(Params[0]), Zero = vdupq_n_f32(0.0f), One = vdupq_n_f32(1.0f);
+    int32_t i = 0;
+    for (; i + 4 <= Count; i += 4)
+    {
+        float32x4_t X = vmulq_n_f32(vsubq_f32(vld1q_f32(S + i), Min), Params[1]);
+        vst1q_f32(D + i, vminnmq_f32(vmaxnmq_f32(X, Zero), One));
+    }
+    SharedConvert_NormalizeDepthScalar(D + i, S + i, Count - i, Params);
+}
+
+#endif // defined(CONVERT_NEON)
+
+//
+// DISPATCH
+//
+
+typedef struct shared_convert_kernels
+{
+    shared_convert_row *SwizzleRB;
+    shared_convert_row *UnormToFloat;
+    shared_convert_row *FloatToUnorm;
+    shared_convert_row *FloatToHalf;
+    shared_convert_row *HalfToFloat;
+    shared_convert_row *SrgbToLinear;
+    shared_convert_row *LinearToSrgb;
+    shared_convert_row *NormalizeDepth;
+} shared_convert_kernels;
+
+static const shared_convert_kernels SharedConvert_Kernels[SHARED_CONVERT_LEVEL_COUNT] = {
+    [SHARED_CONVERT_SCALAR] = {
+        SharedConvert_SwizzleRBScalar, SharedConvert_UnormToFloatScalar, SharedConvert_FloatToUnormScalar,
+        SharedConvert_FloatToHalfScalar, SharedConvert_HalfToFloatScalar, SharedConvert_SrgbToLinearScalar,
+        SharedConvert_LinearToSrgbScalar, SharedConvert_NormalizeDepthScalar,
+    },
+#if defined(CONVERT_X86)
+    [SHARED_CONVERT_SSE2] = {
+        SharedConvert_SwizzleRBSse2, SharedConvert_UnormToFloatSse2, SharedConvert_FloatToUnormSse2,
+        SharedConvert_FloatToHalfSse2, SharedConvert_HalfToFloatSse2, SharedConvert_SrgbToLinearScalar,
+        SharedConvert_LinearToSrgbTable, SharedConvert_NormalizeDepthSse2,
+    },
+    [SHARED_CONVERT_AVX2] = {
+        SharedConvert_SwizzleRBAvx2, SharedConvert_UnormToFloatAvx2, SharedConvert_FloatToUnormAvx2,
+        SharedConvert_FloatToHalfAvx2, SharedConvert_HalfToFloatAvx2, SharedConvert_SrgbToLinearAvx2,
+        SharedConvert_LinearToSrgbAvx2, SharedConvert_NormalizeDepthAvx2,
+    },
+#endif
+#if defined(CONVERT_NEON)
+    [SHARED_CONVERT_NEON] = {
+        SharedConvert_SwizzleRBNeon, SharedConvert_UnormToFloatNeon, SharedConvert_FloatToUnormNeon,
+        SharedConvert_FloatToHalfNeon, SharedConvert_HalfToFloatNeon, SharedConvert_SrgbToLinearScalar,
+        SharedConvert_LinearToSrgbTable, SharedConvert_NormalizeDepthNeon,
+    },
+#endif
+};
+
+static void SharedConvert_Init(void)
+{
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        Convert.SrgbToLinear[i] = SharedConvert_DecodeSrgb((float)i / 255.0f);
+        Convert.SrgbToLinear[256 + i] = (float)i * (1.0f / 255.0f);
+    }
+    for (uint32_t i = 0; i < 4096; ++i)
+        Convert.LinearToSrgb[i] = SharedConvert_ToUnorm(SharedConvert_EncodeSrgb((float)i / 4095.0f));
+
+    Convert.Supported = 1u << SHARED_CONVERT_SCALAR;
+#if defined(CONVERT_X86)
+    // SSE2 is part of x86-64 and of every x86 CPU that runs Vulkan drivers.
+    Convert.Supported |= 1u << SHARED_CONVERT_SSE2;
+    if (SharedConvert_HasAvx2())
+        Convert.Supported |= 1u << SHARED_CONVERT_AVX2;
+#endif
+#if defined(CONVERT_NEON)
+    Convert.Supported |= 1u << SHARED_CONVERT_NEON;
+#endif
+    for (uint32_t Level = 0; Level < SHARED_CONVERT_LEVEL_COUNT; ++Level)
+        if (Convert.Supported & (1u << Level))
+            Convert.Level = Level;
+}
+
+#if defined(_WIN32)
+
+static INIT_ONCE SharedConvert_Once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK SharedConvert_InitOnce(PINIT_ONCE Once, PVOID Parameter, PVOID *Context)
+{
+    SharedConvert_Init();
+    return TRUE;
+}
+
+static const shared_convert_kernels *SharedConvert_GetKernels(void)
+{
+    InitOnceExecuteOnce(&SharedConvert_Once, SharedConvert_InitOnce, NULL, NULL);
+    return &SharedConvert_Kernels[Convert.Level];
+}
+
+#else
+
+static pthread_once_t SharedConvert_Once = PTHREAD_ONCE_INIT;
+
+static const shared_convert_kernels *SharedConvert_GetKernels(void)
+{
+    pthread_once(&SharedConvert_Once, SharedConvert_Init);
+    return &SharedConvert_Kernels[Convert.Level];
+}
+
+#endif
+
+static void SharedConvert_Rows(shared_convert_row *Row, void *Dst, int64_t DstPitch, const void *Src, int64_t SrcPitch,
+                               int32_t Count, int32_t Height, const float *Params)
+{
+    for (int32_t y = 0; y < Height; ++y)
+        Row((uint8_t *)Dst + y * DstPitch, (const uint8_t *)Src + y * SrcPitch, Count, Params);
+}
+
+uint32_t SHARED_TEXTURE_EXPORT SharedConvert_GetLevel(void)
+{
+    SharedConvert_GetKernels();
+    return Convert.Level;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedConvert_SetLevel(uint32_t Level)
+{
+    SharedConvert_GetKernels();
+    if (Level >= SHARED_CONVERT_LEVEL_COUNT || !(Convert.Supported & (1u << Level)))
+        return false;
+    Convert.Level = Level;
+    return true;
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_Copy(void *Dst, int64_t DstPitch, const void *Src, int64_t SrcPitch, uint64_t RowSize, int32_t Height)
+{
+    SharedTexture_HostCopy(Dst, DstPitch, Src, SrcPitch, RowSize, Height);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_SwizzleRB(uint8_t *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->SwizzleRB, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_UnormToFloat(float *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->UnormToFloat, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_FloatToUnorm(uint8_t *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->FloatToUnorm, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_FloatToHalf(uint16_t *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->FloatToHalf, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_HalfToFloat(float *Dst, int64_t DstPitch, const uint16_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->HalfToFloat, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_SrgbToLinear(float *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->SrgbToLinear, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_LinearToSrgb(uint8_t *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height)
+{
+    SharedConvert_Rows(SharedConvert_GetKernels()->LinearToSrgb, Dst, DstPitch, Src, SrcPitch, Width * 4, Height, 0);
+}
+
+void SHARED_TEXTURE_EXPORT SharedConvert_NormalizeDepth(float *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height, float Min, float Max)
+{
+    float Params[2] = { Min, Max != Min ? 1.0f / (Max - Min) : 0.0f };
+    SharedConvert_Rows(SharedConvert_GetKernels()->NormalizeDepth, Dst, DstPitch, Src, SrcPitch, Width, Height, Params);
+}
@@ -0,0 +1,54 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+#pragma once
+
+#include "share.h"
+
+// Pixel conversions for readback and CPU textures. Every function converts
+// Height rows of Width texels, pitches are in bytes and may be negative, so
+// passing the last source row with a negative pitch flips vertically. RGBA
+// functions take four channels per texel, depth functions one.
+//
+// Kernels are picked once per process from the best of SSE2, AVX2 (with F16C)
+// and NEON. SharedConvert_SetLevel selects another level, the scalar one is the
+// reference the others are meant to match: table based sRGB encoding may be 1
+// off, NaN payloads may differ in half conversions, everything else should be
+// equal bit for bit. Copies go through SharedTexture_HostCopy.
+
+typedef enum shared_convert_level
+{
+    SHARED_CONVERT_SCALAR = 0,
+    SHARED_CONVERT_SSE2,
+    SHARED_CONVERT_AVX2,
+    SHARED_CONVERT_NEON,
+    SHARED_CONVERT_LEVEL_COUNT,
+} shared_convert_level;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t SHARED_TEXTURE_EXPORT SharedConvert_GetLevel(void);
+// Returns false if the CPU does not support Level.
+bool SHARED_TEXTURE_EXPORT SharedConvert_SetLevel(uint32_t Level);
+
+// Copies rows of RowSize bytes, e.g. to flip.
+void SHARED_TEXTURE_EXPORT SharedConvert_Copy(void *Dst, int64_t DstPitch, const void *Src, int64_t SrcPitch, uint64_t RowSize, int32_t Height);
+// RGBA8 <-> BGRA8, Dst may be Src.
+void SHARED_TEXTURE_EXPORT SharedConvert_SwizzleRB(uint8_t *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+void SHARED_TEXTURE_EXPORT SharedConvert_UnormToFloat(float *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+// Clamps to [0, 1] and rounds, NaN becomes 0.
+void SHARED_TEXTURE_EXPORT SharedConvert_FloatToUnorm(uint8_t *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+// Rounds to nearest even like the GPU, out of range values become infinity.
+void SHARED_TEXTURE_EXPORT SharedConvert_FloatToHalf(uint16_t *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+void SHARED_TEXTURE_EXPORT SharedConvert_HalfToFloat(float *Dst, int64_t DstPitch, const uint16_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+// SHARED_TEXTURE_RGBA8_SRGB to linear float and back, alpha is linear in both.
+void SHARED_TEXTURE_EXPORT SharedConvert_SrgbToLinear(float *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+void SHARED_TEXTURE_EXPORT SharedConvert_LinearToSrgb(uint8_t *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height);
+// Maps depth in [Min, Max] to [0, 1] and clamps, e.g. to look at SHARED_TEXTURE_DEPTH. Dst may be Src.
+void SHARED_TEXTURE_EXPORT SharedConvert_NormalizeDepth(float *Dst, int64_t DstPitch, const float *Src, int64_t SrcPitch, int32_t Width, int32_t Height, float Min, float Max);
+
+#ifdef __cplusplus
+}
+#endif
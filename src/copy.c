@@ -0,0 +1,225 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+// Copy pool behind SharedTexture_HostCopy. A copy is cut into stripes of whole
+// rows of about COPY_STRIPE_SIZE bytes, which the caller and every worker take
+// in turn until none are left. One copy runs at a time, the workers are
+// started by the first copy large enough to need them and live as long as the
+// process.
+#define COPY_STRIPE_SIZE (256 * 1024)
+#define COPY_PARALLEL_SIZE (4 * 1024 * 1024)
+#define COPY_MAX_THREADS 15
+
+static struct
+{
+#if defined(_WIN32)
+    SRWLOCK JobLock;        // one copy at a time
+    SRWLOCK Lock;
+    CONDITION_VARIABLE Changed;
+#else
+    pthread_mutex_t JobLock;
+    pthread_mutex_t Lock;
+    pthread_cond_t Changed;
+#endif
+    bool Started;
+    bool ThreadCountSet;
+    uint32_t ThreadCount;
+    uint64_t Job;           // bumped for every copy, workers wait for the next one
+    uint32_t Busy;          // workers still on the current copy
+
+    uint8_t *Dst;
+    const uint8_t *Src;
+    int64_t DstPitch, SrcPitch;
+    uint64_t RowSize;
+    int32_t Height;
+    int32_t StripeRows;
+    int32_t StripeCount;
+    volatile int32_t NextStripe;
+} Copy = {
+#if !defined(_WIN32)
+    .JobLock = PTHREAD_MUTEX_INITIALIZER,
+    .Lock = PTHREAD_MUTEX_INITIALIZER,
+    .Changed = PTHREAD_COND_INITIALIZER,
+#endif
+};
+
+#if defined(_WIN32)
+  #define COPY_LOCK() AcquireSRWLockExclusive(&Copy.Lock)
+  #define COPY_UNLOCK() ReleaseSRWLockExclusive(&Copy.Lock)
+  #define COPY_WAIT() SleepConditionVariableSRW(&Copy.Changed, &Copy.Lock, INFINITE, 0)
+  #define COPY_WAKE() WakeAllConditionVariable(&Copy.Changed)
+  #define COPY_JOB_LOCK() AcquireSRWLockExclusive(&Copy.JobLock)
+  #define COPY_JOB_UNLOCK() ReleaseSRWLockExclusive(&Copy.JobLock)
+  #define COPY_TAKE_STRIPE() (InterlockedIncrement((volatile LONG *)&Copy.NextStripe) - 1)
+#else
+  #define COPY_LOCK() pthread_mutex_lock(&Copy.Lock)
+  #define COPY_UNLOCK() pthread_mutex_unlock(&Copy.Lock)
+  #define COPY_WAIT() pthread_cond_wait(&Copy.Changed, &Copy.Lock)
+  #define COPY_WAKE() pthread_cond_broadcast(&Copy.Changed)
+  #define COPY_JOB_LOCK() pthread_mutex_lock(&Copy.JobLock)
+  #define COPY_JOB_UNLOCK() pthread_mutex_unlock(&Copy.JobLock)
+  #define COPY_TAKE_STRIPE() __atomic_fetch_add(&Copy.NextStripe, 1, __ATOMIC_RELAXED)
+#endif
+
+static void SharedTexture_CopyRows(uint8_t *Dst, int64_t DstPitch, const uint8_t *Src, int64_t SrcPitch, uint64_t RowSize, int32_t Height)
+{
+    if (DstPitch == (int64_t)RowSize && SrcPitch == (int64_t)RowSize)
+    {
+        memcpy(Dst, Src, RowSize * Height);
+        return;
+    }
+    for (int32_t y = 0; y < Height; ++y)
+        memcpy(Dst + y * DstPitch, Src + y * SrcPitch, RowSize);
+}
+
+static void SharedTexture_CopyStripes(void)
+{
+    for (;;)
+    {
+        int32_t Stripe = COPY_TAKE_STRIPE();
+        if (Stripe >= Copy.StripeCount)
+            break;
+        int32_t First = Stripe * Copy.StripeRows;
+        int32_t Rows = Copy.Height - First < Copy.StripeRows ? Copy.Height - First : Copy.StripeRows;
+        SharedTexture_CopyRows(Copy.Dst + First * Copy.DstPitch, Copy.DstPitch, Copy.Src + First * Copy.SrcPitch, Copy.SrcPitch,
+                               Copy.RowSize, Rows);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI SharedTexture_CopyThreadProc(LPVOID Parameter)
+#else
+static void *SharedTexture_CopyThreadProc(void *Parameter)
+#endif
+{
+    // Workers start before the first copy is posted, so none is missed.
+    uint64_t Seen = 0;
+    COPY_LOCK();
+    for (;;)
+    {
+        while (Copy.Job == Seen)
+            COPY_WAIT();
+        Seen = Copy.Job;
+        COPY_UNLOCK();
+
+        SharedTexture_CopyStripes();
+
+        COPY_LOCK();
+        if (--Copy.Busy == 0)
+            COPY_WAKE();
+    }
+    return 0;
+}
+
+// Called with JobLock held. Returns false if there are no workers.
+static bool SharedTexture_StartCopyThreads(void)
+{
+    if (Copy.Started)
+        return Copy.ThreadCount > 0;
+    Copy.Started = true;
+
+    if (!Copy.ThreadCountSet)
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO SystemInfo;
+        GetSystemInfo(&SystemInfo);
+        uint32_t HardwareThreads = SystemInfo.dwNumberOfProcessors;
+#else
+        long HardwareThreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        Copy.ThreadCount = HardwareThreads > 2 ? (uint32_t)HardwareThreads / 2 - 1 : 0;
+        if (Copy.ThreadCount > COPY_MAX_THREADS)
+            Copy.ThreadCount = COPY_MAX_THREADS;
+    }
+
+    for (uint32_t i = 0; i < Copy.ThreadCount; ++i)
+    {
+#if defined(_WIN32)
+        HANDLE Thread = CreateThread(NULL, 0, SharedTexture_CopyThreadProc, NULL, 0, NULL);
+        bool Created = Thread != NULL;
+        if (Created)
+            CloseHandle(Thread);
+#else
+        pthread_t Thread;
+        bool Created = pthread_create(&Thread, NULL, SharedTexture_CopyThreadProc, NULL) == 0;
+        if (Created)
+            pthread_detach(Thread);
+#endif
+        if (!Created)
+        {
+            Copy.ThreadCount = i;
+            break;
+        }
+    }
+    return Copy.ThreadCount > 0;
+}
+
+void SHARED_TEXTURE_EXPORT SharedTexture_HostCopy(void *Dst, int64_t DstPitch, const void *Src, int64_t SrcPitch, uint64_t RowSize, int32_t Height)
+{
+    if (RowSize * Height < COPY_PARALLEL_SIZE)
+    {
+        SharedTexture_CopyRows(Dst, DstPitch, Src, SrcPitch, RowSize, Height);
+        return;
+    }
+
+    COPY_JOB_LOCK();
+    if (!SharedTexture_StartCopyThreads())
+    {
+        COPY_JOB_UNLOCK();
+        SharedTexture_CopyRows(Dst, DstPitch, Src, SrcPitch, RowSize, Height);
+        return;
+    }
+
+    COPY_LOCK();
+    Copy.Dst = Dst;
+    Copy.Src = Src;
+    Copy.DstPitch = DstPitch;
+    Copy.SrcPitch = SrcPitch;
+    Copy.RowSize = RowSize;
+    Copy.Height = Height;
+    Copy.StripeRows = RowSize < COPY_STRIPE_SIZE ? (int32_t)(COPY_STRIPE_SIZE / RowSize) : 1;
+    Copy.StripeCount = (Height + Copy.StripeRows - 1) / Copy.StripeRows;
+    Copy.NextStripe = 0;
+    Copy.Busy = Copy.ThreadCount;
+    Copy.Job++;
+    COPY_WAKE();
+    COPY_UNLOCK();
+
+    SharedTexture_CopyStripes();
+
+    COPY_LOCK();
+    while (Copy.Busy)
+        COPY_WAIT();
+    COPY_UNLOCK();
+    COPY_JOB_UNLOCK();
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetCopyThreads(uint32_t Count)
+{
+    COPY_JOB_LOCK();
+    bool Set = !Copy.Started;
+    if (Set)
+    {
+        Copy.ThreadCount = Count < COPY_MAX_THREADS ? Count : COPY_MAX_THREADS;
+        Copy.ThreadCountSet = true;
+    }
+    COPY_JOB_UNLOCK();
+    return Set;
+}
+
+uint32_t SHARED_TEXTURE_EXPORT SharedTexture_CurrentNumaNode(void)
+{
+#if defined(_WIN32)
+    PROCESSOR_NUMBER Processor;
+    USHORT Node;
+    GetCurrentProcessorNumberEx(&Processor);
+    if (!GetNumaProcessorNodeEx(&Processor, &Node))
+        return 0;
+    return (uint32_t)Node + 1;
+#else
+    unsigned Cpu, Node;
+    if (syscall(SYS_getcpu, &Cpu, &Node, NULL) != 0)
+        return 0;
+    return Node + 1;
+#endif
+}
@@ -0,0 +1,500 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+#pragma once
+
+#include "share.h"
+
+// Asynchronous download of shared textures to the CPU. Every read copies into
+// the next slot of a ring of persistently mapped staging buffers, the callback
+// sees the frame once the GPU finished the copy, SlotCount - 1 reads later at
+// the latest. Nothing waits on the GPU unless all slots are in flight.
+//
+// 2D textures only; multisampled textures are read through SharedTexture_ToResolve.
+
+#define SHARED_READBACK_MAX_SLOTS 8
+
+// Data is only valid during the call, see convert.h to swizzle or convert it.
+// Frame counts the reads of the ring.
+typedef void (*shared_readback_callback)(void *UserData, const uint8_t *Data, uint64_t RowPitch, int64_t Frame);
+
+#if defined(SHARED_TEXTURE_OPENGL)
+
+typedef struct gl_shared_readback
+{
+    GLuint Buffers[SHARED_READBACK_MAX_SLOTS];
+    uint8_t *Data[SHARED_READBACK_MAX_SLOTS];
+    GLsync Fences[SHARED_READBACK_MAX_SLOTS];
+    int64_t Frames[SHARED_READBACK_MAX_SLOTS];
+    uint32_t SlotCount;
+    uint32_t Next;
+    uint32_t Pending;
+    int64_t Frame;
+    int32_t Width, Height;
+    GLenum Format, Type;
+    uint64_t RowPitch;
+    shared_readback_callback Callback;
+    void *UserData;
+} gl_shared_readback;
+
+static bool SharedReadback_CreateOpenGL(gl_shared_readback *Readback, shared_texture SharedTexture, uint32_t SlotCount, shared_readback_callback Callback, void *UserData);
+static void SharedReadback_DestroyOpenGL(gl_shared_readback *Readback);
+static void SharedReadback_OpenGLRead(gl_shared_readback *Readback, gl_shared_texture GLSharedTexture);
+static bool SharedReadback_OpenGLDeliver(gl_shared_readback *Readback, bool Wait);
+static void SharedReadback_OpenGLPoll(gl_shared_readback *Readback);
+static void SharedReadback_OpenGLFlush(gl_shared_readback *Readback);
+
+#endif // defined(SHARED_TEXTURE_OPENGL)
+
+#if defined(SHARED_TEXTURE_VULKAN)
+
+typedef struct vk_shared_readback
+{
+    VkBuffer Buffer;        // SlotCount slots of SlotSize bytes
+    VkDeviceMemory Memory;
+    uint8_t *Data;
+    bool Coherent;
+    VkCommandPool CommandPool;
+    VkCommandBuffer CommandBuffers[SHARED_READBACK_MAX_SLOTS];
+    VkSemaphore Timeline;
+    uint64_t Values[SHARED_READBACK_MAX_SLOTS]; // timeline value that completes the slot
+    int64_t Frames[SHARED_READBACK_MAX_SLOTS];
+    uint64_t Value;
+    uint32_t SlotCount;
+    uint32_t Next;
+    uint32_t Pending;
+    int64_t Frame;
+    int32_t Width, Height;
+    VkImageAspectFlags Aspect;
+    uint64_t RowPitch;
+    uint64_t SlotSize;
+    shared_readback_callback Callback;
+    void *UserData;
+    VkDevice Device;
+    uint32_t QueueFamilyIndex;
+} vk_shared_readback;
+
+static bool SharedReadback_CreateVulkan(vk_shared_readback *Readback, shared_texture SharedTexture, uint32_t SlotCount, shared_readback_callback Callback, void *UserData,
+                                        VkDevice Device, VkPhysicalDevice PhysicalDevice, uint32_t QueueFamilyIndex);
+static void SharedReadback_DestroyVulkan(vk_shared_readback *Readback);
+static bool SharedReadback_VulkanRead(vk_shared_readback *Readback, vk_shared_texture VKSharedTexture, VkQueue Queue, VkImageLayout Layout, VkImageLayout ReleaseLayout);
+static bool SharedReadback_VulkanDeliver(vk_shared_readback *Readback, bool Wait);
+static void SharedReadback_VulkanPoll(vk_shared_readback *Readback);
+static void SharedReadback_VulkanFlush(vk_shared_readback *Readback);
+
+#endif // defined(SHARED_TEXTURE_VULKAN)
+
+////////////////////////
+//                    //
+//   IMPLEMENTATION   //
+//                    //
+////////////////////////
+
+#if defined(SHARED_TEXTURE_OPENGL)
+
+PFNGLNAMEDBUFFERSTORAGEPROC glNamedBufferStorage;
+PFNGLMAPNAMEDBUFFERRANGEPROC glMapNamedBufferRange;
+PFNGLUNMAPNAMEDBUFFERPROC glUnmapNamedBuffer;
+PFNGLBINDBUFFERPROC glBindBuffer;
+PFNGLGETTEXTUREIMAGEPROC glGetTextureImage;
+PFNGLFENCESYNCPROC glFenceSync;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+PFNGLDELETESYNCPROC glDeleteSync;
+
+static bool SharedReadback_CreateOpenGL(gl_shared_readback *Readback, shared_texture SharedTexture, uint32_t SlotCount, shared_readback_callback Callback, void *UserData)
+{
+    uint32_t TexelSize = SharedTexture_CpuTexelSize(SharedTexture.Format);
+    if (!TexelSize || SharedTexture.Type != SHARED_TEXTURE_2D || SharedTexture.Samples > 1 ||
+        SlotCount == 0 || SlotCount > SHARED_READBACK_MAX_SLOTS)
+        return false;
+
+    *Readback = (gl_shared_readback) { 0 };
+    Readback->SlotCount = SlotCount;
+    Readback->Width = SharedTexture.Width;
+    Readback->Height = SharedTexture.Height;
+    Readback->RowPitch = (uint64_t)SharedTexture.Width * TexelSize;
+    Readback->Callback = Callback;
+    Readback->UserData = UserData;
+    switch (SharedTexture.Format)
+    {
+        case SHARED_TEXTURE_DEPTH: Readback->Format = GL_DEPTH_COMPONENT; Readback->Type = GL_FLOAT; break;
+        case SHARED_TEXTURE_RGBA8_UINT: Readback->Format = GL_RGBA_INTEGER; Readback->Type = GL_UNSIGNED_BYTE; break;
+        case SHARED_TEXTURE_RGBA16F: Readback->Format = GL_RGBA; Readback->Type = GL_HALF_FLOAT; break;
+        case SHARED_TEXTURE_RGB10A2: Readback->Format = GL_RGBA; Readback->Type = GL_UNSIGNED_INT_2_10_10_10_REV; break;
+        default: Readback->Format = GL_RGBA; Readback->Type = GL_UNSIGNED_BYTE; break;
+    }
+
+    // Persistent coherent mappings stay valid while the GPU writes, the fence
+    // alone tells when a slot is ready.
+    GLsizeiptr Size = (GLsizeiptr)(Readback->RowPitch * SharedTexture.Height);
+    GLbitfield Access = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(SlotCount, Readback->Buffers);
+    for (uint32_t i = 0; i < SlotCount; ++i)
+    {
+        glNamedBufferStorage(Readback->Buffers[i], Size, 0, Access | GL_CLIENT_STORAGE_BIT);
+        Readback->Data[i] = (uint8_t *)glMapNamedBufferRange(Readback->Buffers[i], 0, Size, Access);
+        if (!Readback->Data[i])
+        {
+            SharedReadback_DestroyOpenGL(Readback);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SharedReadback_DestroyOpenGL(gl_shared_readback *Readback)
+{
+    for (uint32_t i = 0; i < Readback->SlotCount; ++i)
+    {
+        if (Readback->Fences[i])
+            glDeleteSync(Readback->Fences[i]);
+        if (Readback->Data[i])
+            glUnmapNamedBuffer(Readback->Buffers[i]);
+    }
+    glDeleteBuffers(Readback->SlotCount, Readback->Buffers);
+    *Readback = (gl_shared_readback) { 0 };
+}
+
+// Call between SharedTexture_OpenGLWait and SharedTexture_OpenGLSignal.
+static void SharedReadback_OpenGLRead(gl_shared_readback *Readback, gl_shared_texture GLSharedTexture)
+{
+    if (Readback->Pending == Readback->SlotCount)
+        SharedReadback_OpenGLDeliver(Readback, true);
+
+    uint32_t Slot = Readback->Next;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, Readback->Buffers[Slot]);
+    glGetTextureImage(GLSharedTexture.Texture, 0, Readback->Format, Readback->Type, (GLsizei)(Readback->RowPitch * Readback->Height), 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    Readback->Fences[Slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    Readback->Frames[Slot] = Readback->Frame++;
+    Readback->Next = (Slot + 1) % Readback->SlotCount;
+    Readback->Pending++;
+
+    SharedReadback_OpenGLPoll(Readback);
+}
+
+// Hands the oldest pending slot to the callback if its copy is done, or waits for it.
+static bool SharedReadback_OpenGLDeliver(gl_shared_readback *Readback, bool Wait)
+{
+    if (!Readback->Pending)
+        return false;
+
+    uint32_t Slot = (Readback->Next + Readback->SlotCount - Readback->Pending) % Readback->SlotCount;
+    GLenum Result = glClientWaitSync(Readback->Fences[Slot], GL_SYNC_FLUSH_COMMANDS_BIT, Wait ? UINT64_MAX : 0);
+    if (Result == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    // A failed wait drops the frame, the slot is reused and must not keep its fence.
+    glDeleteSync(Readback->Fences[Slot]);
+    Readback->Fences[Slot] = 0;
+    Readback->Pending--;
+    if (Result != GL_WAIT_FAILED && Readback->Callback)
+        Readback->Callback(Readback->UserData, Readback->Data[Slot], Readback->RowPitch, Readback->Frames[Slot]);
+    return true;
+}
+
+static void SharedReadback_OpenGLPoll(gl_shared_readback *Readback)
+{
+    while (SharedReadback_OpenGLDeliver(Readback, false));
+}
+
+static void SharedReadback_OpenGLFlush(gl_shared_readback *Readback)
+{
+    while (SharedReadback_OpenGLDeliver(Readback, true));
+}
+
+#endif // defined(SHARED_TEXTURE_OPENGL)
+
+#if defined(SHARED_TEXTURE_VULKAN)
+
+PFN_vkMapMemory vkMapMemory;
+PFN_vkUnmapMemory vkUnmapMemory;
+PFN_vkInvalidateMappedMemoryRanges vkInvalidateMappedMemoryRanges;
+PFN_vkCreateCommandPool vkCreateCommandPool;
+PFN_vkDestroyCommandPool vkDestroyCommandPool;
+PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
+PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
+PFN_vkEndCommandBuffer vkEndCommandBuffer;
+PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer;
+PFN_vkQueueSubmit vkQueueSubmit;
+PFN_vkGetSemaphoreCounterValue vkGetSemaphoreCounterValue;
+PFN_vkWaitSemaphores vkWaitSemaphores;
+
+// Device needs the timelineSemaphore feature.
+static bool SharedReadback_CreateVulkan(vk_shared_readback *Readback, shared_texture SharedTexture, uint32_t SlotCount, shared_readback_callback Callback, void *UserData,
+                                        VkDevice Device, VkPhysicalDevice PhysicalDevice, uint32_t QueueFamilyIndex)
+{
+    uint32_t TexelSize = SharedTexture_CpuTexelSize(SharedTexture.Format);
+    if (!TexelSize || SharedTexture.Type != SHARED_TEXTURE_2D || SharedTexture.Samples > 1 ||
+        SlotCount == 0 || SlotCount > SHARED_READBACK_MAX_SLOTS)
+        return false;
+
+    *Readback = (vk_shared_readback) { 0 };
+    Readback->SlotCount = SlotCount;
+    Readback->Width = SharedTexture.Width;
+    Readback->Height = SharedTexture.Height;
+    Readback->Aspect = SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    Readback->RowPitch = (uint64_t)SharedTexture.Width * TexelSize;
+    Readback->SlotSize = Readback->RowPitch * SharedTexture.Height;
+    Readback->Callback = Callback;
+    Readback->UserData = UserData;
+    Readback->Device = Device;
+    Readback->QueueFamilyIndex = QueueFamilyIndex;
+
+    // BUFFER
+    VkBufferCreateInfo BufferCreateInfo;
+    BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    BufferCreateInfo.pNext = 0;
+    BufferCreateInfo.flags = 0;
+    BufferCreateInfo.size = Readback->SlotSize * SlotCount;
+    BufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    BufferCreateInfo.queueFamilyIndexCount = 0;
+    BufferCreateInfo.pQueueFamilyIndices = 0;
+    if (vkCreateBuffer(Device, &BufferCreateInfo, 0, &Readback->Buffer) != VK_SUCCESS)
+        return false;
+
+    // MEMORY
+    // Same preference as mapped host textures, cached first.
+    VkMemoryRequirements MemReqs;
+    vkGetBufferMemoryRequirements(Device, Readback->Buffer, &MemReqs);
+    shared_texture Host = SharedTexture;
+    Host.Flags |= SHARED_TEXTURE_FLAG_HOST;
+    uint32_t MemoryTypeIndex = SharedTexture_FindVulkanMemoryType(Host, MemReqs.memoryTypeBits, PhysicalDevice);
+    if (MemoryTypeIndex == UINT32_MAX)
+    {
+        SharedReadback_DestroyVulkan(Readback);
+        return false;
+    }
+    VkPhysicalDeviceMemoryProperties MemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(PhysicalDevice, &MemoryProperties);
+    Readback->Coherent = (MemoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    VkMemoryAllocateInfo MemoryAllocateInfo;
+    MemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    MemoryAllocateInfo.pNext = 0;
+    MemoryAllocateInfo.allocationSize = MemReqs.size;
+    MemoryAllocateInfo.memoryTypeIndex = MemoryTypeIndex;
+    if (vkAllocateMemory(Device, &MemoryAllocateInfo, 0, &Readback->Memory) != VK_SUCCESS ||
+        vkBindBufferMemory(Device, Readback->Buffer, Readback->Memory, 0) != VK_SUCCESS ||
+        vkMapMemory(Device, Readback->Memory, 0, VK_WHOLE_SIZE, 0, (void **)&Readback->Data) != VK_SUCCESS)
+    {
+        SharedReadback_DestroyVulkan(Readback);
+        return false;
+    }
+
+    // COMMAND BUFFERS
+    // One per slot, re-recorded on reuse once its timeline value has passed.
+    VkCommandPoolCreateInfo CommandPoolCreateInfo;
+    CommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    CommandPoolCreateInfo.pNext = 0;
+    CommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    CommandPoolCreateInfo.queueFamilyIndex = QueueFamilyIndex;
+    VkCommandBufferAllocateInfo CommandBufferAllocateInfo;
+    CommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    CommandBufferAllocateInfo.pNext = 0;
+    if (vkCreateCommandPool(Device, &CommandPoolCreateInfo, 0, &Readback->CommandPool) != VK_SUCCESS)
+    {
+        SharedReadback_DestroyVulkan(Readback);
+        return false;
+    }
+    CommandBufferAllocateInfo.commandPool = Readback->CommandPool;
+    CommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    CommandBufferAllocateInfo.commandBufferCount = SlotCount;
+    if (vkAllocateCommandBuffers(Device, &CommandBufferAllocateInfo, Readback->CommandBuffers) != VK_SUCCESS)
+    {
+        SharedReadback_DestroyVulkan(Readback);
+        return false;
+    }
+
+    // TIMELINE
+    VkSemaphoreTypeCreateInfo SemaphoreTypeCreateInfo;
+    SemaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    SemaphoreTypeCreateInfo.pNext = 0;
+    SemaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    SemaphoreTypeCreateInfo.initialValue = 0;
+    VkSemaphoreCreateInfo SemaphoreCreateInfo;
+    SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    SemaphoreCreateInfo.pNext = &SemaphoreTypeCreateInfo;
+    SemaphoreCreateInfo.flags = 0;
+    if (vkCreateSemaphore(Device, &SemaphoreCreateInfo, 0, &Readback->Timeline) != VK_SUCCESS)
+    {
+        SharedReadback_DestroyVulkan(Readback);
+        return false;
+    }
+    return true;
+}
+
+// Waits for copies in flight, but does not deliver them.
+static void SharedReadback_DestroyVulkan(vk_shared_readback *Readback)
+{
+    VkDevice Device = Readback->Device;
+    if (Readback->Timeline)
+    {
+        VkSemaphoreWaitInfo SemaphoreWaitInfo;
+        SemaphoreWaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        SemaphoreWaitInfo.pNext = 0;
+        SemaphoreWaitInfo.flags = 0;
+        SemaphoreWaitInfo.semaphoreCount = 1;
+        SemaphoreWaitInfo.pSemaphores = &Readback->Timeline;
+        SemaphoreWaitInfo.pValues = &Readback->Value;
+        vkWaitSemaphores(Device, &SemaphoreWaitInfo, UINT64_MAX);
+        vkDestroySemaphore(Device, Readback->Timeline, 0);
+    }
+    if (Readback->CommandPool)
+        vkDestroyCommandPool(Device, Readback->CommandPool, 0);
+    if (Readback->Buffer)
+        vkDestroyBuffer(Device, Readback->Buffer, 0);
+    if (Readback->Memory)
+        vkFreeMemory(Device, Readback->Memory, 0);
+    *Readback = (vk_shared_readback) { 0 };
+}
+
+// Takes the place of the consumer's own wait and signal for this frame: the
+// submit waits on the texture's semaphore, acquires the image in Layout,
+// copies from it, releases it in ReleaseLayout and signals the semaphore
+// again. Layout is usually SharedTexture_VulkanLayout of the texture, publish
+// ReleaseLayout with SharedTexture_StoreLayout once this returned true.
+static bool SharedReadback_VulkanRead(vk_shared_readback *Readback, vk_shared_texture VKSharedTexture, VkQueue Queue, VkImageLayout Layout, VkImageLayout ReleaseLayout)
+{
+    if (Readback->Pending == Readback->SlotCount)
+        SharedReadback_VulkanDeliver(Readback, true);
+
+    uint32_t Slot = Readback->Next;
+    VkCommandBuffer CommandBuffer = Readback->CommandBuffers[Slot];
+    VkCommandBufferBeginInfo CommandBufferBeginInfo;
+    CommandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    CommandBufferBeginInfo.pNext = 0;
+    CommandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    CommandBufferBeginInfo.pInheritanceInfo = 0;
+    vkBeginCommandBuffer(CommandBuffer, &CommandBufferBeginInfo);
+
+    VkImageMemoryBarrier Barrier;
+    Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    Barrier.pNext = 0;
+    Barrier.srcAccessMask = 0;
+    Barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    Barrier.oldLayout = Layout;
+    Barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    Barrier.dstQueueFamilyIndex = Readback->QueueFamilyIndex;
+    Barrier.image = VKSharedTexture.Image;
+    Barrier.subresourceRange.aspectMask = Readback->Aspect;
+    Barrier.subresourceRange.baseMipLevel = 0;
+    Barrier.subresourceRange.levelCount = 1;
+    Barrier.subresourceRange.baseArrayLayer = 0;
+    Barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &Barrier);
+
+    VkBufferImageCopy Region;
+    Region.bufferOffset = Readback->SlotSize * Slot;
+    Region.bufferRowLength = 0;
+    Region.bufferImageHeight = 0;
+    Region.imageSubresource.aspectMask = Readback->Aspect;
+    Region.imageSubresource.mipLevel = 0;
+    Region.imageSubresource.baseArrayLayer = 0;
+    Region.imageSubresource.layerCount = 1;
+    Region.imageOffset.x = 0;
+    Region.imageOffset.y = 0;
+    Region.imageOffset.z = 0;
+    Region.imageExtent.width = Readback->Width;
+    Region.imageExtent.height = Readback->Height;
+    Region.imageExtent.depth = 1;
+    vkCmdCopyImageToBuffer(CommandBuffer, VKSharedTexture.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, Readback->Buffer, 1, &Region);
+
+    // The copy has to be made visible to host reads, the image goes to ReleaseLayout.
+    VkMemoryBarrier HostBarrier;
+    HostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    HostBarrier.pNext = 0;
+    HostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    HostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    Barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    Barrier.dstAccessMask = 0;
+    Barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    Barrier.newLayout = ReleaseLayout;
+    Barrier.srcQueueFamilyIndex = Readback->QueueFamilyIndex;
+    Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 1, &HostBarrier, 0, 0, 1, &Barrier);
+    vkEndCommandBuffer(CommandBuffer);
+
+    uint64_t Value = Readback->Value + 1;
+    const VkSemaphore SignalSemaphores[2] = { VKSharedTexture.Semaphore, Readback->Timeline };
+    const uint64_t SignalValues[2] = { 0, Value };
+    const VkPipelineStageFlags WaitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkTimelineSemaphoreSubmitInfo TimelineSemaphoreSubmitInfo;
+    TimelineSemaphoreSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    TimelineSemaphoreSubmitInfo.pNext = 0;
+    TimelineSemaphoreSubmitInfo.waitSemaphoreValueCount = 0;
+    TimelineSemaphoreSubmitInfo.pWaitSemaphoreValues = 0;
+    TimelineSemaphoreSubmitInfo.signalSemaphoreValueCount = 2;
+    TimelineSemaphoreSubmitInfo.pSignalSemaphoreValues = SignalValues;
+    VkSubmitInfo SubmitInfo;
+    SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    SubmitInfo.pNext = &TimelineSemaphoreSubmitInfo;
+    SubmitInfo.waitSemaphoreCount = 1;
+    SubmitInfo.pWaitSemaphores = &VKSharedTexture.Semaphore;
+    SubmitInfo.pWaitDstStageMask = &WaitStage;
+    SubmitInfo.commandBufferCount = 1;
+    SubmitInfo.pCommandBuffers = &CommandBuffer;
+    SubmitInfo.signalSemaphoreCount = 2;
+    SubmitInfo.pSignalSemaphores = SignalSemaphores;
+    if (vkQueueSubmit(Queue, 1, &SubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        return false;
+
+    Readback->Value = Value;
+    Readback->Values[Slot] = Value;
+    Readback->Frames[Slot] = Readback->Frame++;
+    Readback->Next = (Slot + 1) % Readback->SlotCount;
+    Readback->Pending++;
+
+    SharedReadback_VulkanPoll(Readback);
+    return true;
+}
+
+// Hands the oldest pending slot to the callback if its copy is done, or waits for it.
+static bool SharedReadback_VulkanDeliver(vk_shared_readback *Readback, bool Wait)
+{
+    if (!Readback->Pending)
+        return false;
+
+    uint32_t Slot = (Readback->Next + Readback->SlotCount - Readback->Pending) % Readback->SlotCount;
+    VkSemaphoreWaitInfo SemaphoreWaitInfo;
+    SemaphoreWaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    SemaphoreWaitInfo.pNext = 0;
+    SemaphoreWaitInfo.flags = 0;
+    SemaphoreWaitInfo.semaphoreCount = 1;
+    SemaphoreWaitInfo.pSemaphores = &Readback->Timeline;
+    SemaphoreWaitInfo.pValues = &Readback->Values[Slot];
+    if (vkWaitSemaphores(Readback->Device, &SemaphoreWaitInfo, Wait ? UINT64_MAX : 0) != VK_SUCCESS)
+        return false;
+
+    const uint8_t *Data = Readback->Data + Readback->SlotSize * Slot;
+    if (!Readback->Coherent)
+    {
+        VkMappedMemoryRange Range;
+        Range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        Range.pNext = 0;
+        Range.memory = Readback->Memory;
+        Range.offset = 0;
+        Range.size = VK_WHOLE_SIZE;
+        vkInvalidateMappedMemoryRanges(Readback->Device, 1, &Range);
+    }
+
+    Readback->Pending--;
+    if (Readback->Callback)
+        Readback->Callback(Readback->UserData, Data, Readback->RowPitch, Readback->Frames[Slot]);
+    return true;
+}
+
+static void SharedReadback_VulkanPoll(vk_shared_readback *Readback)
+{
+    while (SharedReadback_VulkanDeliver(Readback, false));
+}
+
+static void SharedReadback_VulkanFlush(vk_shared_readback *Readback)
+{
+    while (SharedReadback_VulkanDeliver(Readback, true));
+}
+
+#endif // defined(SHARED_TEXTURE_VULKAN)
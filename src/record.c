@@ -0,0 +1,404 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+#include "readback.h"
+#include "record.h"
+
+// Frames are copied out of the readback ring into a queue of aligned buffers
+// and written by a separate thread with unbuffered, sequential writes of whole
+// frames, so neither the GPU nor the page cache sits between frame and disk.
+
+#if defined(_WIN32)
+
+typedef HANDLE record_file;
+#define RECORD_FILE_NONE INVALID_HANDLE_VALUE
+
+static record_file SharedRecorder_OpenFile(const char *Path)
+{
+    return CreateFileA(Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+}
+
+// Data, Size and Offset are multiples of SHARED_RECORD_ALIGNMENT.
+static bool SharedRecorder_WriteAt(record_file File, const void *Data, uint64_t Size, uint64_t Offset)
+{
+    const uint8_t *Bytes = Data;
+    while (Size)
+    {
+        DWORD Chunk = Size > (1u << 30) ? (1u << 30) : (DWORD)Size;
+        OVERLAPPED Overlapped = { 0 };
+        Overlapped.Offset = (DWORD)Offset;
+        Overlapped.OffsetHigh = (DWORD)(Offset >> 32);
+        DWORD Written = 0;
+        if (!WriteFile(File, Bytes, Chunk, &Written, &Overlapped) || Written != Chunk)
+            return false;
+        Bytes += Chunk;
+        Offset += Chunk;
+        Size -= Chunk;
+    }
+    return true;
+}
+
+static void SharedRecorder_CloseFile(record_file File)
+{
+    CloseHandle(File);
+}
+
+static void *SharedRecorder_AlignedAlloc(uint64_t Size)
+{
+    return _aligned_malloc(Size, SHARED_RECORD_ALIGNMENT);
+}
+
+static void SharedRecorder_AlignedFree(void *Data)
+{
+    _aligned_free(Data);
+}
+
+#else
+
+typedef int record_file;
+#define RECORD_FILE_NONE -1
+
+static record_file SharedRecorder_OpenFile(const char *Path)
+{
+    int Flags = O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC;
+#if defined(O_DIRECT)
+    // Not every file system takes O_DIRECT, fall back to the page cache there.
+    int File = open(Path, Flags | O_DIRECT, 0644);
+    if (File >= 0)
+        return File;
+#endif
+    return open(Path, Flags, 0644);
+}
+
+// Data, Size and Offset are multiples of SHARED_RECORD_ALIGNMENT.
+static bool SharedRecorder_WriteAt(record_file File, const void *Data, uint64_t Size, uint64_t Offset)
+{
+    const uint8_t *Bytes = Data;
+    while (Size)
+    {
+        ssize_t Written = pwrite(File, Bytes, Size, (off_t)Offset);
+        if (Written <= 0)
+            return false;
+        Bytes += Written;
+        Offset += Written;
+        Size -= Written;
+    }
+    return true;
+}
+
+static void SharedRecorder_CloseFile(record_file File)
+{
+    close(File);
+}
+
+static void *SharedRecorder_AlignedAlloc(uint64_t Size)
+{
+    void *Data = 0;
+    if (posix_memalign(&Data, SHARED_RECORD_ALIGNMENT, Size) != 0)
+        return 0;
+    return Data;
+}
+
+static void SharedRecorder_AlignedFree(void *Data)
+{
+    free(Data);
+}
+
+#endif
+
+typedef struct shared_recorder_state
+{
+    shared_texture SharedTexture;
+    vk_shared_texture Texture;
+    vk_shared_readback Readback;
+    VkQueue Queue;              // see SharedTexture_CopyQueue
+    shared_record_header Header;
+    record_file File;
+    // One more than the ring, a full ring delivers its oldest frame while
+    // the next one's timestamp is already stored.
+    int64_t Timestamps[SHARED_READBACK_MAX_SLOTS + 1];
+
+    // Frame queue between the readback callback and the writer thread.
+#if defined(_WIN32)
+    SRWLOCK Lock;
+    CONDITION_VARIABLE Changed;
+    HANDLE Thread;
+#else
+    pthread_mutex_t Lock;
+    pthread_cond_t Changed;
+    pthread_t Thread;
+#endif
+    uint8_t **Buffers;
+    shared_record_entry *Queued;
+    uint32_t QueueDepth;
+    uint32_t Head;
+    uint32_t Count;
+    bool Stop;
+    bool Failed;
+
+    // Writer thread only.
+    uint64_t Offset;
+    shared_record_entry *Index;
+    uint64_t IndexCapacity;
+} shared_recorder_state;
+
+#if defined(_WIN32)
+  #define RECORDER_LOCK(State) AcquireSRWLockExclusive(&(State)->Lock)
+  #define RECORDER_UNLOCK(State) ReleaseSRWLockExclusive(&(State)->Lock)
+  #define RECORDER_WAIT(State) SleepConditionVariableSRW(&(State)->Changed, &(State)->Lock, INFINITE, 0)
+  #define RECORDER_WAKE(State) WakeAllConditionVariable(&(State)->Changed)
+#else
+  #define RECORDER_LOCK(State) pthread_mutex_lock(&(State)->Lock)
+  #define RECORDER_UNLOCK(State) pthread_mutex_unlock(&(State)->Lock)
+  #define RECORDER_WAIT(State) pthread_cond_wait(&(State)->Changed, &(State)->Lock)
+  #define RECORDER_WAKE(State) pthread_cond_broadcast(&(State)->Changed)
+#endif
+
+static void SharedRecorder_Deliver(void *UserData, const uint8_t *Data, uint64_t RowPitch, int64_t Frame)
+{
+    shared_recorder_state *State = UserData;
+
+    RECORDER_LOCK(State);
+    while (State->Count == State->QueueDepth && !State->Failed)
+        RECORDER_WAIT(State);
+    bool Failed = State->Failed;
+    uint32_t Slot = (State->Head + State->Count) % State->QueueDepth;
+    RECORDER_UNLOCK(State);
+    if (Failed)
+        return;
+
+    // The writer does not touch slots past Head + Count, copy without the lock.
+    memcpy(State->Buffers[Slot], Data, State->Header.FrameSize);
+    State->Queued[Slot] = (shared_record_entry) {
+        .Timestamp = State->Timestamps[Frame % (SHARED_READBACK_MAX_SLOTS + 1)],
+        .Frame = Frame,
+        .Format = State->Header.Format,
+    };
+
+    RECORDER_LOCK(State);
+    State->Count++;
+    RECORDER_WAKE(State);
+    RECORDER_UNLOCK(State);
+}
+
+static bool SharedRecorder_WriteFrame(shared_recorder_state *State, uint32_t Slot)
+{
+    if (State->Header.FrameCount == State->IndexCapacity)
+    {
+        uint64_t Capacity = State->IndexCapacity ? State->IndexCapacity * 2 : 1024;
+        shared_record_entry *Index = realloc(State->Index, Capacity * sizeof(shared_record_entry));
+        if (!Index)
+            return false;
+        State->Index = Index;
+        State->IndexCapacity = Capacity;
+    }
+    if (!SharedRecorder_WriteAt(State->File, State->Buffers[Slot], State->Header.FrameStride, State->Offset))
+        return false;
+
+    shared_record_entry Entry = State->Queued[Slot];
+    Entry.Offset = State->Offset;
+    State->Index[State->Header.FrameCount++] = Entry;
+    State->Offset += State->Header.FrameStride;
+    return true;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI SharedRecorder_WriteThreadProc(LPVOID Parameter)
+#else
+static void *SharedRecorder_WriteThreadProc(void *Parameter)
+#endif
+{
+    shared_recorder_state *State = Parameter;
+    for (;;)
+    {
+        RECORDER_LOCK(State);
+        while (State->Count == 0 && !State->Stop)
+            RECORDER_WAIT(State);
+        if (State->Count == 0)
+        {
+            RECORDER_UNLOCK(State);
+            break;
+        }
+        uint32_t Slot = State->Head;
+        RECORDER_UNLOCK(State);
+
+        bool Written = SharedRecorder_WriteFrame(State, Slot);
+
+        RECORDER_LOCK(State);
+        State->Head = (State->Head + 1) % State->QueueDepth;
+        State->Count--;
+        State->Failed |= !Written;
+        RECORDER_WAKE(State);
+        RECORDER_UNLOCK(State);
+    }
+    return 0;
+}
+
+static void SharedRecorder_Destroy(shared_recorder_state *State)
+{
+    if (State->Readback.Device)
+        SharedReadback_DestroyVulkan(&State->Readback);
+    SharedTexture_DestroyVulkanTexture(State->Texture, VK.Device);
+    if (State->File != RECORD_FILE_NONE)
+        SharedRecorder_CloseFile(State->File);
+    for (uint32_t i = 0; State->Buffers && i < State->QueueDepth; ++i)
+        SharedRecorder_AlignedFree(State->Buffers[i]);
+    free(State->Buffers);
+    free(State->Queued);
+    free(State->Index);
+    free(State);
+}
+
+bool SHARED_TEXTURE_EXPORT SharedRecorder_Create(shared_recorder *Recorder, const char *Path, shared_texture SharedTexture, uint32_t QueueDepth)
+{
+    *Recorder = (shared_recorder) { 0 };
+    uint32_t TexelSize = SharedTexture_CpuTexelSize(SharedTexture.Format);
+    if (!TexelSize || SharedTexture.Type != SHARED_TEXTURE_2D || SharedTexture.Samples > 1 || !SharedTexture_RequireDevice() || VK.Queue == VK_NULL_HANDLE || (SharedTexture.Flags & (SHARED_TEXTURE_FLAG_HEAP | SHARED_TEXTURE_FLAG_DMA_BUF)))
+        return false;
+
+    shared_recorder_state *State = calloc(1, sizeof(shared_recorder_state));
+    if (!State)
+        return false;
+    State->SharedTexture = SharedTexture;
+    State->File = RECORD_FILE_NONE;
+    State->QueueDepth = QueueDepth ? QueueDepth : 4;
+    State->Header = (shared_record_header) {
+        .Magic = SHARED_RECORD_MAGIC,
+        .Format = SharedTexture.Format,
+        .Width = SharedTexture.Width,
+        .Height = SharedTexture.Height,
+        .Primaries = SharedTexture.Primaries,
+        .Transfer = SharedTexture.Transfer,
+        .RowPitch = (uint64_t)SharedTexture.Width * TexelSize,
+        .FrameSize = (uint64_t)SharedTexture.Width * TexelSize * SharedTexture.Height,
+        .HeaderSize = SHARED_RECORD_ALIGNMENT,
+    };
+    State->Header.FrameStride = (State->Header.FrameSize + SHARED_RECORD_ALIGNMENT - 1) & ~(uint64_t)(SHARED_RECORD_ALIGNMENT - 1);
+    State->Offset = State->Header.HeaderSize;
+
+    State->Buffers = calloc(State->QueueDepth, sizeof(uint8_t *));
+    State->Queued = calloc(State->QueueDepth, sizeof(shared_record_entry));
+    if (!State->Buffers || !State->Queued)
+    {
+        SharedRecorder_Destroy(State);
+        return false;
+    }
+    for (uint32_t i = 0; i < State->QueueDepth; ++i)
+    {
+        State->Buffers[i] = SharedRecorder_AlignedAlloc(State->Header.FrameStride);
+        if (!State->Buffers[i])
+        {
+            SharedRecorder_Destroy(State);
+            return false;
+        }
+        memset(State->Buffers[i] + State->Header.FrameSize, 0, State->Header.FrameStride - State->Header.FrameSize);
+    }
+
+    uint32_t QueueFamilyIndex;
+    State->Queue = SharedTexture_CopyQueue(&QueueFamilyIndex);
+    State->Texture = SharedTexture_ToVulkan(SharedTexture, VK.Device, VK.PhysicalDevice);
+    State->File = SharedRecorder_OpenFile(Path);
+    if (State->File == RECORD_FILE_NONE || State->Texture.Image == VK_NULL_HANDLE ||
+        !SharedReadback_CreateVulkan(&State->Readback, SharedTexture, SHARED_READBACK_MAX_SLOTS, SharedRecorder_Deliver, State,
+                                     VK.Device, VK.PhysicalDevice, QueueFamilyIndex))
+    {
+        SharedRecorder_Destroy(State);
+        return false;
+    }
+
+    // The header is written again with the index on close.
+    memset(State->Buffers[0], 0, SHARED_RECORD_ALIGNMENT);
+    memcpy(State->Buffers[0], &State->Header, sizeof(shared_record_header));
+    if (!SharedRecorder_WriteAt(State->File, State->Buffers[0], SHARED_RECORD_ALIGNMENT, 0))
+    {
+        SharedRecorder_Destroy(State);
+        return false;
+    }
+
+#if defined(_WIN32)
+    InitializeSRWLock(&State->Lock);
+    InitializeConditionVariable(&State->Changed);
+    State->Thread = CreateThread(NULL, 0, SharedRecorder_WriteThreadProc, State, 0, NULL);
+    if (!State->Thread)
+#else
+    pthread_mutex_init(&State->Lock, NULL);
+    pthread_cond_init(&State->Changed, NULL);
+    if (pthread_create(&State->Thread, NULL, SharedRecorder_WriteThreadProc, State) != 0)
+#endif
+    {
+        SharedRecorder_Destroy(State);
+        return false;
+    }
+
+    Recorder->Internal = State;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedRecorder_Record(shared_recorder *Recorder, int64_t Timestamp)
+{
+    shared_recorder_state *State = Recorder->Internal;
+    if (!State)
+        return false;
+    RECORDER_LOCK(State);
+    bool Failed = State->Failed;
+    RECORDER_UNLOCK(State);
+    if (Failed)
+        return false;
+
+    State->Timestamps[State->Readback.Frame % (SHARED_READBACK_MAX_SLOTS + 1)] = Timestamp;
+    // Until something was published there is nothing to keep, the image is
+    // acquired as is and handed back in a layout every API can name.
+    VkImageLayout Layout = SharedTexture_VulkanLayout(State->SharedTexture);
+    VkImageLayout ReleaseLayout = Layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : Layout;
+    if (!SharedReadback_VulkanRead(&State->Readback, State->Texture, State->Queue, Layout, ReleaseLayout))
+        return false;
+    SharedTexture_StoreLayout(State->SharedTexture, SharedTexture_FromVulkanLayout(ReleaseLayout));
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedRecorder_Close(shared_recorder *Recorder)
+{
+    shared_recorder_state *State = Recorder->Internal;
+    if (!State)
+        return false;
+    *Recorder = (shared_recorder) { 0 };
+
+    SharedReadback_VulkanFlush(&State->Readback);
+    RECORDER_LOCK(State);
+    State->Stop = true;
+    RECORDER_WAKE(State);
+    RECORDER_UNLOCK(State);
+#if defined(_WIN32)
+    WaitForSingleObject(State->Thread, INFINITE);
+    CloseHandle(State->Thread);
+#else
+    pthread_join(State->Thread, NULL);
+#endif
+
+    // Index and header go through an aligned buffer as well.
+    bool Succeeded = !State->Failed;
+    uint64_t IndexSize = State->Header.FrameCount * sizeof(shared_record_entry);
+    uint64_t IndexStride = (IndexSize + SHARED_RECORD_ALIGNMENT - 1) & ~(uint64_t)(SHARED_RECORD_ALIGNMENT - 1);
+    uint8_t *Block = SharedRecorder_AlignedAlloc(IndexStride + SHARED_RECORD_ALIGNMENT);
+    if (Block && Succeeded)
+    {
+        memset(Block, 0, IndexStride + SHARED_RECORD_ALIGNMENT);
+        memcpy(Block, State->Index, IndexSize);
+        State->Header.IndexOffset = State->Offset;
+        Succeeded = SharedRecorder_WriteAt(State->File, Block, IndexStride, State->Offset);
+
+        uint8_t *HeaderBlock = Block + IndexStride;
+        memcpy(HeaderBlock, &State->Header, sizeof(shared_record_header));
+        Succeeded = Succeeded && SharedRecorder_WriteAt(State->File, HeaderBlock, SHARED_RECORD_ALIGNMENT, 0);
+    }
+    if (Block)
+        SharedRecorder_AlignedFree(Block);
+
+#if !defined(_WIN32)
+    pthread_mutex_destroy(&State->Lock);
+    pthread_cond_destroy(&State->Changed);
+#endif
+    SharedRecorder_Destroy(State);
+    return Block && Succeeded;
+}
@@ -0,0 +1,82 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+#pragma once
+
+#include "share.h"
+
+// Frames recorded from a shared texture. The file is append-only: one header
+// block, every frame at a SHARED_RECORD_ALIGNMENT aligned offset and the index
+// of all frames last, so frames can be read by seeking or straight from a
+// mapping of the file. A file without IndexOffset was not closed properly,
+// its frames are still at HeaderSize + i * FrameStride.
+#define SHARED_RECORD_MAGIC 0x31304345525453ull   // "STREC01"
+#define SHARED_RECORD_ALIGNMENT 4096
+
+typedef struct shared_record_header
+{
+    uint64_t Magic;
+    uint32_t Format;
+    int32_t Width, Height;
+    uint32_t Primaries;
+    uint32_t Transfer;
+    uint32_t Reserved;
+    uint64_t RowPitch;
+    uint64_t FrameSize;     // bytes of texels per frame
+    uint64_t FrameStride;   // FrameSize rounded up to SHARED_RECORD_ALIGNMENT
+    uint64_t HeaderSize;    // offset of the first frame
+    uint64_t FrameCount;    // 0 until the recorder is closed
+    uint64_t IndexOffset;   // of FrameCount shared_record_entry, 0 until the recorder is closed
+} shared_record_header;
+
+typedef struct shared_record_entry
+{
+    uint64_t Offset;        // of the frame's texels in the file
+    int64_t Timestamp;      // nanoseconds, as passed to SharedRecorder_Record
+    int64_t Frame;          // number of the SharedRecorder_Record call
+    uint32_t Format;
+    uint32_t Reserved;
+} shared_record_entry;
+
+typedef struct shared_recorder
+{
+    void *Internal;
+} shared_recorder;
+
+// Records through the library's own Vulkan device, so the recording process
+// needs no graphics context. The texture is recorded as it is at creation,
+// create a new recorder after it was resized.
+bool SHARED_TEXTURE_EXPORT SharedRecorder_Create(shared_recorder *Recorder, const char *Path, shared_texture SharedTexture, uint32_t QueueDepth);
+// Queues a copy of the current contents in place of a consumer's wait and
+// signal. Frames reach the file a few calls later, only blocks if the disk
+// falls behind by more than QueueDepth frames.
+bool SHARED_TEXTURE_EXPORT SharedRecorder_Record(shared_recorder *Recorder, int64_t Timestamp);
+// Writes every queued frame and the index.
+bool SHARED_TEXTURE_EXPORT SharedRecorder_Close(shared_recorder *Recorder);
+
+// Paces SharedReplay_Next.
+typedef enum shared_replay_timing
+{
+    SHARED_REPLAY_TIMING_RECORDED = 0,      // the timestamps of the recording
+    SHARED_REPLAY_TIMING_FIXED,             // Fps frames per second
+    SHARED_REPLAY_TIMING_UNTHROTTLED,       // as fast as the GPU uploads
+} shared_replay_timing;
+
+typedef struct shared_replay
+{
+    shared_texture SharedTexture;           // created under the name given to SharedReplay_Open
+    uint64_t FrameCount;
+    void *Internal;
+} shared_replay;
+
+// Maps a recorded file and creates a shared texture Name with its format and
+// size, which SharedReplay_Next fills frame by frame. Uploads go through the
+// library's own Vulkan device, so replaying needs no graphics context.
+bool SHARED_TEXTURE_EXPORT SharedReplay_Open(shared_replay *Replay, const char *Path, const char *Name, uint32_t Timing, double Fps);
+// Waits until the next frame is due and publishes it: waits on the texture's
+// semaphore (except for the first frame), uploads and signals it. Returns
+// false after the last frame.
+bool SHARED_TEXTURE_EXPORT SharedReplay_Next(shared_replay *Replay);
+// Continues with Frame, timing restarts from there.
+bool SHARED_TEXTURE_EXPORT SharedReplay_Seek(shared_replay *Replay, uint64_t Frame);
+void SHARED_TEXTURE_EXPORT SharedReplay_Close(shared_replay *Replay);
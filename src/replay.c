@@ -0,0 +1,468 @@
+// Copyright 2023 Visual Computing Group, Ulm University
+// Author: Jan Eric Haßler
+
+#include "record.h"
+
+// Frames are read straight from a read-only mapping of the recording, pages of
+// the next frames are prefetched while the current one uploads. Uploads go
+// through a small ring of staging slots, a slot is only waited on when the GPU
+// is still copying from it REPLAY_SLOTS frames later.
+#define REPLAY_SLOTS 3
+#define REPLAY_PREFETCH 4
+
+#if defined(_WIN32)
+
+typedef struct replay_file
+{
+    HANDLE File;
+    HANDLE Mapping;
+} replay_file;
+
+static const uint8_t *SharedReplay_MapFile(const char *Path, replay_file *File, uint64_t *Size)
+{
+    File->File = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    File->Mapping = NULL;
+    LARGE_INTEGER FileSize;
+    if (File->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(File->File, &FileSize))
+        return 0;
+    *Size = (uint64_t)FileSize.QuadPart;
+    File->Mapping = CreateFileMappingA(File->File, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!File->Mapping)
+        return 0;
+    return MapViewOfFile(File->Mapping, FILE_MAP_READ, 0, 0, 0);
+}
+
+static void SharedReplay_UnmapFile(const uint8_t *Data, replay_file *File, uint64_t Size)
+{
+    if (Data)
+        UnmapViewOfFile(Data);
+    if (File->Mapping)
+        CloseHandle(File->Mapping);
+    if (File->File != INVALID_HANDLE_VALUE)
+        CloseHandle(File->File);
+}
+
+static void SharedReplay_Prefetch(const uint8_t *Data, uint64_t Size)
+{
+    WIN32_MEMORY_RANGE_ENTRY Range;
+    Range.VirtualAddress = (void *)Data;
+    Range.NumberOfBytes = (SIZE_T)Size;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &Range, 0);
+}
+
+static int64_t SharedReplay_Now(void)
+{
+    LARGE_INTEGER Frequency, Counter;
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Counter);
+    return (int64_t)((double)Counter.QuadPart * 1e9 / (double)Frequency.QuadPart);
+}
+
+static void SharedReplay_SleepUntil(int64_t Time)
+{
+    int64_t Remaining = Time - SharedReplay_Now();
+    if (Remaining > 1000000)
+        Sleep((DWORD)(Remaining / 1000000));
+}
+
+#else
+
+typedef struct replay_file
+{
+    int File;
+} replay_file;
+
+static const uint8_t *SharedReplay_MapFile(const char *Path, replay_file *File, uint64_t *Size)
+{
+    File->File = open(Path, O_RDONLY | O_CLOEXEC);
+    struct stat Stat;
+    if (File->File < 0 || fstat(File->File, &Stat) != 0 || Stat.st_size == 0)
+        return 0;
+    *Size = (uint64_t)Stat.st_size;
+    void *Data = mmap(0, *Size, PROT_READ, MAP_SHARED, File->File, 0);
+    if (Data == MAP_FAILED)
+        return 0;
+    madvise(Data, *Size, MADV_SEQUENTIAL);
+    return Data;
+}
+
+static void SharedReplay_UnmapFile(const uint8_t *Data, replay_file *File, uint64_t Size)
+{
+    if (Data)
+        munmap((void *)Data, Size);
+    if (File->File >= 0)
+        close(File->File);
+}
+
+static void SharedReplay_Prefetch(const uint8_t *Data, uint64_t Size)
+{
+    // madvise wants page aligned addresses, frames start on SHARED_RECORD_ALIGNMENT.
+    madvise((void *)Data, Size, MADV_WILLNEED);
+}
+
+static int64_t SharedReplay_Now(void)
+{
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (int64_t)Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+static void SharedReplay_SleepUntil(int64_t Time)
+{
+    struct timespec Until = { .tv_sec = Time / 1000000000, .tv_nsec = Time % 1000000000 };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Until, 0) == EINTR);
+}
+
+#endif
+
+typedef struct shared_replay_state
+{
+    replay_file File;
+    const uint8_t *Data;
+    uint64_t Size;
+    shared_record_header Header;
+    const shared_record_entry *Index;
+    shared_record_entry *RebuiltIndex;
+
+    vk_shared_texture Texture;
+    VkImageAspectFlags Aspect;
+    VkBuffer Buffer;            // REPLAY_SLOTS slots of Header.FrameSize bytes
+    VkDeviceMemory Memory;
+    uint8_t *Staging;
+    bool Coherent;
+    VkQueue Queue;              // see SharedTexture_CopyQueue
+    uint32_t QueueFamilyIndex;
+    VkCommandPool CommandPool;
+    VkCommandBuffer CommandBuffers[REPLAY_SLOTS];
+    VkSemaphore Timeline;
+    uint64_t Values[REPLAY_SLOTS];
+    uint64_t Value;
+    bool Published;
+
+    uint32_t Timing;
+    double Fps;
+    uint64_t Next;
+    uint64_t StartFrame;
+    int64_t StartTime;
+} shared_replay_state;
+
+static void SharedReplay_Destroy(shared_replay_state *State)
+{
+    if (State->Timeline)
+    {
+        VkSemaphoreWaitInfo SemaphoreWaitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores = &State->Timeline,
+            .pValues = &State->Value,
+        };
+        VK.Funcs.vkWaitSemaphores(VK.Device, &SemaphoreWaitInfo, UINT64_MAX);
+        VK.Funcs.vkDestroySemaphore(VK.Device, State->Timeline, 0);
+    }
+    if (State->CommandPool)
+        VK.Funcs.vkDestroyCommandPool(VK.Device, State->CommandPool, 0);
+    if (State->Buffer)
+        VK.Funcs.vkDestroyBuffer(VK.Device, State->Buffer, 0);
+    if (State->Memory)
+        VK.Funcs.vkFreeMemory(VK.Device, State->Memory, 0);
+    SharedTexture_DestroyVulkanTexture(State->Texture, VK.Device);
+    SharedReplay_UnmapFile(State->Data, &State->File, State->Size);
+    free(State->RebuiltIndex);
+    free(State);
+}
+
+static bool SharedReplay_CreateStaging(shared_replay_state *State, shared_texture SharedTexture)
+{
+    VkResult Result = VK.Funcs.vkCreateBuffer(VK.Device,
+        &(VkBufferCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = State->Header.FrameSize * REPLAY_SLOTS,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        },
+        0, &State->Buffer
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements MemReqs;
+    VK.Funcs.vkGetBufferMemoryRequirements(VK.Device, State->Buffer, &MemReqs);
+    shared_texture Host = SharedTexture;
+    Host.Flags |= SHARED_TEXTURE_FLAG_HOST;
+    uint32_t MemoryTypeIndex = SharedTexture_FindVulkanMemoryType(Host, MemReqs.memoryTypeBits, VK.PhysicalDevice);
+    if (MemoryTypeIndex == UINT32_MAX)
+        return false;
+    VkPhysicalDeviceMemoryProperties MemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(VK.PhysicalDevice, &MemoryProperties);
+    State->Coherent = (MemoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    Result = VK.Funcs.vkAllocateMemory(VK.Device,
+        &(VkMemoryAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = MemReqs.size,
+            .memoryTypeIndex = MemoryTypeIndex,
+        },
+        0, &State->Memory
+    );
+    if (Result != VK_SUCCESS ||
+        VK.Funcs.vkBindBufferMemory(VK.Device, State->Buffer, State->Memory, 0) != VK_SUCCESS ||
+        VK.Funcs.vkMapMemory(VK.Device, State->Memory, 0, VK_WHOLE_SIZE, 0, (void **)&State->Staging) != VK_SUCCESS)
+        return false;
+
+    State->Queue = SharedTexture_CopyQueue(&State->QueueFamilyIndex);
+    Result = VK.Funcs.vkCreateCommandPool(VK.Device,
+        &(VkCommandPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = State->QueueFamilyIndex,
+        },
+        0, &State->CommandPool
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    Result = VK.Funcs.vkAllocateCommandBuffers(VK.Device,
+        &(VkCommandBufferAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = State->CommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = REPLAY_SLOTS,
+        },
+        State->CommandBuffers
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+
+    Result = VK.Funcs.vkCreateSemaphore(VK.Device,
+        &(VkSemaphoreCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &(VkSemaphoreTypeCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            },
+        },
+        0, &State->Timeline
+    );
+    return Result == VK_SUCCESS;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedReplay_Open(shared_replay *Replay, const char *Path, const char *Name, uint32_t Timing, double Fps)
+{
+    *Replay = (shared_replay) { 0 };
+    if (!SharedTexture_RequireDevice() || VK.Queue == VK_NULL_HANDLE || (Timing == SHARED_REPLAY_TIMING_FIXED && Fps <= 0.0))
+        return false;
+
+    shared_replay_state *State = calloc(1, sizeof(shared_replay_state));
+    State->Timing = Timing;
+    State->Fps = Fps;
+    State->Data = SharedReplay_MapFile(Path, &State->File, &State->Size);
+    if (!State->Data || State->Size < sizeof(shared_record_header))
+    {
+        SharedReplay_Destroy(State);
+        return false;
+    }
+    memcpy(&State->Header, State->Data, sizeof(shared_record_header));
+    shared_record_header *Header = &State->Header;
+    if (Header->Magic != SHARED_RECORD_MAGIC || Header->FrameStride < Header->FrameSize || Header->HeaderSize > State->Size)
+    {
+        SharedReplay_Destroy(State);
+        return false;
+    }
+
+    // Recordings that were never closed have no index, their frames are
+    // still laid out back to back.
+    if (Header->IndexOffset && Header->IndexOffset <= State->Size &&
+        Header->FrameCount <= (State->Size - Header->IndexOffset) / sizeof(shared_record_entry))
+    {
+        State->Index = (const shared_record_entry *)(State->Data + Header->IndexOffset);
+        // A truncated or damaged file ends with the last frame it fully holds.
+        for (uint64_t i = 0; i < Header->FrameCount; ++i)
+            if (State->Index[i].Offset > State->Size || Header->FrameSize > State->Size - State->Index[i].Offset)
+            {
+                Header->FrameCount = i;
+                break;
+            }
+    }
+    else
+    {
+        Header->FrameCount = Header->FrameStride ? (State->Size - Header->HeaderSize) / Header->FrameStride : 0;
+        State->RebuiltIndex = calloc(Header->FrameCount ? Header->FrameCount : 1, sizeof(shared_record_entry));
+        if (!State->RebuiltIndex)
+        {
+            SharedReplay_Destroy(State);
+            return false;
+        }
+        for (uint64_t i = 0; i < Header->FrameCount; ++i)
+            State->RebuiltIndex[i] = (shared_record_entry) {
+                .Offset = Header->HeaderSize + i * Header->FrameStride,
+                .Frame = (int64_t)i,
+                .Format = Header->Format,
+            };
+        State->Index = State->RebuiltIndex;
+    }
+
+    shared_texture SharedTexture = SharedTexture_CreateEx(Name,
+        &(shared_texture_create_info) {
+            .Type = SHARED_TEXTURE_2D,
+            .Format = Header->Format,
+            .Width = Header->Width,
+            .Height = Header->Height,
+            .Usage = SHARED_TEXTURE_USAGE_DEFAULT | SHARED_TEXTURE_USAGE_TRANSFER_DST,
+            .Primaries = Header->Primaries,
+            .Transfer = Header->Transfer,
+        }
+    );
+    if (SharedTexture.Format == SHARED_TEXTURE_NONE ||
+        Header->FrameSize != (uint64_t)Header->Width * Header->Height * SharedTexture_CpuTexelSize(SharedTexture.Format))
+    {
+        if (SharedTexture.Format != SHARED_TEXTURE_NONE)
+            SharedTexture_Close(SharedTexture);
+        SharedReplay_Destroy(State);
+        return false;
+    }
+    State->Texture = SharedTexture_ToVulkan(SharedTexture, VK.Device, VK.PhysicalDevice);
+    State->Aspect = SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    if (!SharedReplay_CreateStaging(State, SharedTexture))
+    {
+        SharedTexture_Close(SharedTexture);
+        SharedReplay_Destroy(State);
+        return false;
+    }
+
+    if (Header->FrameCount)
+        SharedReplay_Prefetch(State->Data + State->Index[0].Offset, Header->FrameStride * (Header->FrameCount < REPLAY_PREFETCH ? Header->FrameCount : REPLAY_PREFETCH));
+    Replay->SharedTexture = SharedTexture;
+    Replay->FrameCount = Header->FrameCount;
+    Replay->Internal = State;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedReplay_Seek(shared_replay *Replay, uint64_t Frame)
+{
+    shared_replay_state *State = Replay->Internal;
+    if (!State || Frame >= State->Header.FrameCount)
+        return false;
+    State->Next = Frame;
+    State->StartFrame = Frame;
+    State->StartTime = 0;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedReplay_Next(shared_replay *Replay)
+{
+    shared_replay_state *State = Replay->Internal;
+    if (!State || State->Next >= State->Header.FrameCount)
+        return false;
+    const shared_record_entry *Entry = &State->Index[State->Next];
+
+    // Fault in the frames after this one while it is uploaded.
+    uint64_t Prefetch = State->Next + REPLAY_PREFETCH;
+    if (Prefetch < State->Header.FrameCount)
+        SharedReplay_Prefetch(State->Data + State->Index[Prefetch].Offset, State->Header.FrameStride);
+
+    // PACING
+    if (!State->StartTime)
+        State->StartTime = SharedReplay_Now();
+    else if (State->Timing == SHARED_REPLAY_TIMING_RECORDED)
+        SharedReplay_SleepUntil(State->StartTime + (Entry->Timestamp - State->Index[State->StartFrame].Timestamp));
+    else if (State->Timing == SHARED_REPLAY_TIMING_FIXED)
+        SharedReplay_SleepUntil(State->StartTime + (int64_t)((double)(State->Next - State->StartFrame) * 1e9 / State->Fps));
+
+    // STAGING
+    uint32_t Slot = State->Value % REPLAY_SLOTS;
+    if (State->Values[Slot])
+    {
+        VkSemaphoreWaitInfo SemaphoreWaitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .semaphoreCount = 1,
+            .pSemaphores = &State->Timeline,
+            .pValues = &State->Values[Slot],
+        };
+        VK.Funcs.vkWaitSemaphores(VK.Device, &SemaphoreWaitInfo, UINT64_MAX);
+    }
+    uint64_t Offset = State->Header.FrameSize * Slot;
+    memcpy(State->Staging + Offset, State->Data + Entry->Offset, State->Header.FrameSize);
+    if (!State->Coherent)
+        VK.Funcs.vkFlushMappedMemoryRanges(VK.Device, 1,
+            &(VkMappedMemoryRange) {
+                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .memory = State->Memory,
+                .size = VK_WHOLE_SIZE,
+            }
+        );
+
+    // UPLOAD
+    // The frame replaces the whole image, so its old contents are discarded.
+    VkCommandBuffer CommandBuffer = State->CommandBuffers[Slot];
+    VK.Funcs.vkBeginCommandBuffer(CommandBuffer,
+        &(VkCommandBufferBeginInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        }
+    );
+    VkImageMemoryBarrier Barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = State->Texture.Image,
+        .subresourceRange = { State->Aspect, 0, 1, 0, 1 },
+    };
+    VK.Funcs.vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &Barrier);
+    VK.Funcs.vkCmdCopyBufferToImage(CommandBuffer, State->Buffer, State->Texture.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+        &(VkBufferImageCopy) {
+            .bufferOffset = Offset,
+            .imageSubresource = { State->Aspect, 0, 0, 1 },
+            .imageExtent = { State->Header.Width, State->Header.Height, 1 },
+        }
+    );
+    Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barrier.dstAccessMask = 0;
+    Barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    Barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    Barrier.srcQueueFamilyIndex = State->QueueFamilyIndex;
+    Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    VK.Funcs.vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, 1, &Barrier);
+    VK.Funcs.vkEndCommandBuffer(CommandBuffer);
+
+    uint64_t Value = State->Value + 1;
+    VkResult Result = VK.Funcs.vkQueueSubmit(State->Queue, 1,
+        &(VkSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &(VkTimelineSemaphoreSubmitInfo) {
+                .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                .signalSemaphoreValueCount = 2,
+                .pSignalSemaphoreValues = (uint64_t[]){ 0, Value },
+            },
+            // Consumers hand the texture back by signalling, nobody has before the first frame.
+            .waitSemaphoreCount = State->Published ? 1 : 0,
+            .pWaitSemaphores = &State->Texture.Semaphore,
+            .pWaitDstStageMask = (VkPipelineStageFlags[]){ VK_PIPELINE_STAGE_TRANSFER_BIT },
+            .commandBufferCount = 1,
+            .pCommandBuffers = &CommandBuffer,
+            .signalSemaphoreCount = 2,
+            .pSignalSemaphores = (VkSemaphore[]){ State->Texture.Semaphore, State->Timeline },
+        },
+        VK_NULL_HANDLE
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    SharedTexture_StoreLayout(Replay->SharedTexture, SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY);
+
+    State->Value = Value;
+    State->Values[Slot] = Value;
+    State->Published = true;
+    State->Next++;
+    return true;
+}
+
+void SHARED_TEXTURE_EXPORT SharedReplay_Close(shared_replay *Replay)
+{
+    shared_replay_state *State = Replay->Internal;
+    if (!State)
+        return;
+    SharedReplay_Destroy(State);
+    SharedTexture_Close(Replay->SharedTexture);
+    *Replay = (shared_replay) { 0 };
+}
@@ -1,10 +1,16 @@
 // Copyright 2023 Visual Computing Group, Ulm University
 // Author: Jan Eric Haßler
 
+#if !defined(_WIN32)
+  #define _GNU_SOURCE
+#endif
 #define SHARED_TEXTURE_OPENGL
 #define SHARED_TEXTURE_VULKAN
 #include "share.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #if _WIN32
 
 #if _DLL
@@ -14,75 +20,549 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 }
 #endif
 
+#define PIPE_PREFIX "\\\\.\\pipe\\shared_texture_"
+#define HEAP_PIPE_PREFIX "\\\\.\\pipe\\shared_texture_heap_"
+#define BUFFER_PIPE_PREFIX "\\\\.\\pipe\\shared_buffer_"
+
 #else
-  #error posix not implemented
-#endif
 
-#define PIPE_PREFIX "\\\\.\\pipe\\shared_texture_"
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+#define MAX_PATH PATH_MAX
+#define PIPE_PREFIX "shared_texture_"
+#define HEAP_PIPE_PREFIX "shared_texture_heap_"
+#define BUFFER_PIPE_PREFIX "shared_buffer_"
+
+#endif
 
 #if defined(_WIN32)
 
-typedef struct send_thread_data
+struct shared_texture_sender
 {
-    HANDLE Pipe;
-    shared_texture SharedTexture;
-} send_thread_data;
+    char PipeName[MAX_PATH];
+    HANDLE Pipe;            // the first instance, created before the thread starts
+    HANDLE Thread;
+    volatile LONG Stop;
+    uint32_t Size;
+    uint8_t Data[];
+};
+
+static HANDLE SharedTexture_CreatePipe(const char *PipeName, uint32_t Size)
+{
+    return CreateNamedPipeA(PipeName, PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES, Size, 1, 0, NULL);
+}
 
+// Serves every consumer until SharedTexture_StopSend. The next instance is
+// created before one is served, so the name never disappears in between. The
+// consumer duplicates the handles before it closes its end, so the read only
+// returns once they are no longer needed here.
 static DWORD WINAPI SharedTexture_SendThreadProc(LPVOID lpParam)
 {
-    send_thread_data *Data = lpParam;
-    
-    ConnectNamedPipe(Data->Pipe, NULL);
-    WriteFile(Data->Pipe, &Data->SharedTexture, sizeof(shared_texture), NULL, NULL);
-    CloseHandle(Data->Pipe);
-    HeapFree(GetProcessHeap(), 0, Data);
+    shared_texture_sender *Sender = lpParam;
+    HANDLE Pipe = Sender->Pipe;
+    while (Pipe != INVALID_HANDLE_VALUE)
+    {
+        bool Connected = ConnectNamedPipe(Pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED;
+        if (InterlockedCompareExchange(&Sender->Stop, 0, 0))
+        {
+            CloseHandle(Pipe);
+            break;
+        }
 
+        HANDLE Next = SharedTexture_CreatePipe(Sender->PipeName, Sender->Size);
+        if (Connected)
+        {
+            DWORD Written, Read;
+            uint8_t Ack;
+            if (WriteFile(Pipe, Sender->Data, Sender->Size, &Written, NULL))
+                ReadFile(Pipe, &Ack, 1, &Read, NULL);
+            DisconnectNamedPipe(Pipe);
+        }
+        CloseHandle(Pipe);
+        Pipe = Next;
+    }
     return 0;
 }
 
-static bool SharedTexture_Send(shared_texture SharedTexture, const char *Name)
+// Publishes Size bytes under Prefix + Name until SharedTexture_StopSend. Handles
+// inside the data stay valid in this process only, the receiver duplicates
+// them into its own, so they must stay open until then.
+static shared_texture_sender *SharedTexture_Send(const char *Prefix, const char *Name, const void *Data, uint32_t Size,
+                                                 uint32_t HandleCount, const shared_handle *Handles)
 {
-    char PipeName[MAX_PATH] = { 0 };
-    strncpy(PipeName, PIPE_PREFIX, MAX_PATH - 1);
-    strncpy(PipeName + sizeof(PIPE_PREFIX), Name, MAX_PATH - 1 - sizeof(PIPE_PREFIX));
-    HANDLE Pipe = CreateNamedPipeA(PipeName,
-                                   PIPE_ACCESS_OUTBOUND,
-                                   PIPE_TYPE_BYTE | PIPE_WAIT,
-                                   1, sizeof(shared_texture),
-                                   sizeof(shared_texture), 0, NULL);
-    if (Pipe == INVALID_HANDLE_VALUE) return false;
+    shared_texture_sender *Sender = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(shared_texture_sender) + Size);
+    if (!Sender) return NULL;
+    snprintf(Sender->PipeName, MAX_PATH, "%s%s", Prefix, Name);
+    Sender->Size = Size;
+    memcpy(Sender->Data, Data, Size);
+    Sender->Pipe = SharedTexture_CreatePipe(Sender->PipeName, Size);
+    if (Sender->Pipe != INVALID_HANDLE_VALUE)
+        Sender->Thread = CreateThread(NULL, 0, SharedTexture_SendThreadProc, Sender, 0, NULL);
+    if (!Sender->Thread)
+    {
+        if (Sender->Pipe != INVALID_HANDLE_VALUE)
+            CloseHandle(Sender->Pipe);
+        HeapFree(GetProcessHeap(), 0, Sender);
+        return NULL;
+    }
+    return Sender;
+}
 
-    send_thread_data *SendData = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(send_thread_data));
-    SendData->Pipe = Pipe;
-    SendData->SharedTexture = SharedTexture;
-    HANDLE Thread = CreateThread(NULL, 0, SharedTexture_SendThreadProc, SendData, 0, NULL);
-    return true;
+// Waits for consumers that are still being served, afterwards the handles
+// that were sent may be closed.
+static void SharedTexture_StopSend(shared_texture_sender *Sender)
+{
+    if (!Sender) return;
+    InterlockedExchange(&Sender->Stop, 1);
+    // Wakes the thread up in ConnectNamedPipe.
+    HANDLE Pipe = CreateFileA(Sender->PipeName, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    WaitForSingleObject(Sender->Thread, INFINITE);
+    if (Pipe != INVALID_HANDLE_VALUE)
+        CloseHandle(Pipe);
+    CloseHandle(Sender->Thread);
+    HeapFree(GetProcessHeap(), 0, Sender);
 }
 
-static bool SharedTexture_Receive(shared_texture *SharedTexture, const char *Name)
+// Reads Size bytes published under Prefix + Name and duplicates the listed
+// handles, which point into Data, from the sending process. Null handles are skipped.
+static bool SharedTexture_Receive(const char *Prefix, const char *Name, void *Data, uint32_t Size,
+                                  uint32_t HandleCount, shared_handle **Handles)
 {
     char PipeName[MAX_PATH] = { 0 };
-    strncpy(PipeName, PIPE_PREFIX, MAX_PATH - 1);
-    strncpy(PipeName + sizeof(PIPE_PREFIX), Name, MAX_PATH - 1 - sizeof(PIPE_PREFIX));
+    snprintf(PipeName, MAX_PATH, "%s%s", Prefix, Name);
     HANDLE Pipe = CreateFile(PipeName, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
     if (Pipe == INVALID_HANDLE_VALUE) return false;
     
-    ReadFile(Pipe, SharedTexture, sizeof(shared_texture), NULL, NULL);
+    DWORD Read = 0;
+    if (!ReadFile(Pipe, Data, Size, &Read, NULL) || Read != Size)
+    {
+        CloseHandle(Pipe);
+        return false;
+    }
     ULONG ServerProcessId;
     GetNamedPipeServerProcessId(Pipe, &ServerProcessId);
     HANDLE ServerProcess = OpenProcess(PROCESS_ALL_ACCESS, FALSE, ServerProcessId);
-    DuplicateHandle(ServerProcess, SharedTexture->Win32.MemoryHandle, GetCurrentProcess(), &SharedTexture->Win32.MemoryHandle, 0, FALSE, DUPLICATE_SAME_ACCESS);
-    DuplicateHandle(ServerProcess, SharedTexture->Win32.SemaphoreHandle, GetCurrentProcess(), &SharedTexture->Win32.SemaphoreHandle, 0, FALSE, DUPLICATE_SAME_ACCESS);
+    for (uint32_t i = 0; i < HandleCount; ++i)
+        if (*Handles[i])
+            DuplicateHandle(ServerProcess, *Handles[i], GetCurrentProcess(), Handles[i], 0, FALSE, DUPLICATE_SAME_ACCESS);
+    CloseHandle(ServerProcess);
     CloseHandle(Pipe);
 
     return true;
 }
+#define CONTROL_PREFIX "Local\\shared_texture_"
+
+static shared_texture_control *SharedTexture_MapControl(const char *Name, bool Create, HANDLE *Mapping)
+{
+    char MappingName[MAX_PATH] = { 0 };
+    snprintf(MappingName, MAX_PATH, "%s%s", CONTROL_PREFIX, Name);
+    if (Create)
+        *Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(shared_texture_control), MappingName);
+    else
+        *Mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, MappingName);
+    if (!*Mapping) return NULL;
+
+    shared_texture_control *Control = MapViewOfFile(*Mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(shared_texture_control));
+    if (!Control)
+    {
+        CloseHandle(*Mapping);
+        *Mapping = NULL;
+    }
+    return Control;
+}
+
+static void SharedTexture_UnmapControl(shared_texture_control *Control, HANDLE Mapping)
+{
+    if (Control) UnmapViewOfFile(Control);
+    if (Mapping) CloseHandle(Mapping);
+}
+
+static void SharedTexture_StoreGeneration(shared_texture_control *Control, int64_t Generation)
+{
+    InterlockedExchange64(&Control->Generation, Generation);
+}
+
+static void SharedTexture_AddUsage(shared_texture_control *Control, uint32_t Usage)
+{
+    InterlockedOr((volatile LONG *)&Control->Usage, (LONG)Usage);
+}
+
+static void SharedTexture_CloseHandle(HANDLE Handle)
+{
+    if (Handle) CloseHandle(Handle);
+}
+
+// CPU textures live in a pagefile-backed section, an auto-reset event stands
+// in for the semaphore. Large pages need SeLockMemoryPrivilege, without it
+// the section falls back to normal pages.
+static HANDLE SharedTexture_CreateCpuMemory(shared_texture *SharedTexture)
+{
+    DWORD Node = SharedTexture->NumaNode ? SharedTexture->NumaNode - 1 : NUMA_NO_PREFERRED_NODE;
+    uint64_t LargePage = GetLargePageMinimum();
+    if (LargePage && SharedTexture->Size >= LargePage)
+    {
+        uint64_t Size = (SharedTexture->Size + LargePage - 1) & ~(LargePage - 1);
+        HANDLE Memory = CreateFileMappingNumaA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+                                               (DWORD)(Size >> 32), (DWORD)Size, NULL, Node);
+        if (Memory)
+        {
+            SharedTexture->Size = Size;
+            SharedTexture->Flags |= SHARED_TEXTURE_FLAG_HUGE_PAGES;
+            return Memory;
+        }
+    }
+    return CreateFileMappingNumaA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                  (DWORD)(SharedTexture->Size >> 32), (DWORD)SharedTexture->Size, NULL, Node);
+}
+
+static uint8_t *SharedTexture_MapCpuMemory(shared_texture SharedTexture)
+{
+    DWORD Access = FILE_MAP_ALL_ACCESS;
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_HUGE_PAGES)
+        Access |= FILE_MAP_LARGE_PAGES;
+    return MapViewOfFile(SHARED_HANDLE(SharedTexture, MemoryHandle), Access, 0, 0, (SIZE_T)SharedTexture.Size);
+}
+
+static void SharedTexture_UnmapCpuMemory(uint8_t *Data, uint64_t Size)
+{
+    UnmapViewOfFile(Data);
+}
+
+static HANDLE SharedTexture_CreateCpuSemaphore(void)
+{
+    return CreateEventA(NULL, FALSE, FALSE, NULL);
+}
+
+static void SharedTexture_CpuWait(shared_texture_control *Control, HANDLE Semaphore)
+{
+    WaitForSingleObject(Semaphore, INFINITE);
+}
+
+static void SharedTexture_CpuSignal(shared_texture_control *Control, HANDLE Semaphore)
+{
+    SetEvent(Semaphore);
+}
+
 #else
-#error posix not implemented
-static void SharedTexture_Send(shared_texture SharedTexture) { }
-static bool SharedTexture_Receive(shared_texture *SharedTexture) { return true; }
+
+#define SEND_MAX_HANDLES 4
+
+struct shared_texture_sender
+{
+    int Socket;
+    pthread_t Thread;
+    uint32_t Size;
+    uint32_t HandleCount;
+    int Handles[SEND_MAX_HANDLES];
+    uint8_t Data[];
+};
+
+// Abstract socket names, nothing is left behind on disk when the producer dies.
+static socklen_t SharedTexture_SocketAddress(struct sockaddr_un *Address, const char *Prefix, const char *Name)
+{
+    memset(Address, 0, sizeof(struct sockaddr_un));
+    Address->sun_family = AF_UNIX;
+    int Length = snprintf(Address->sun_path + 1, sizeof(Address->sun_path) - 1, "%s%s", Prefix, Name);
+    if (Length < 0 || Length > (int)sizeof(Address->sun_path) - 2)
+        Length = sizeof(Address->sun_path) - 2;
+    return offsetof(struct sockaddr_un, sun_path) + 1 + Length;
+}
+
+// Serves every consumer until SharedTexture_StopSend shuts the socket down.
+// The descriptors are in flight once sendmsg returns.
+static void *SharedTexture_SendThreadProc(void *lpParam)
+{
+    shared_texture_sender *Sender = lpParam;
+
+    for (;;)
+    {
+        int Connection = accept(Sender->Socket, NULL, NULL);
+        if (Connection < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+
+        char ControlData[CMSG_SPACE(sizeof(Sender->Handles))] = { 0 };
+        struct iovec Vector = { .iov_base = Sender->Data, .iov_len = Sender->Size };
+        struct msghdr Message = { .msg_iov = &Vector, .msg_iovlen = 1 };
+        if (Sender->HandleCount)
+        {
+            Message.msg_control = ControlData;
+            Message.msg_controllen = CMSG_SPACE(Sender->HandleCount * sizeof(int));
+            struct cmsghdr *Header = CMSG_FIRSTHDR(&Message);
+            Header->cmsg_level = SOL_SOCKET;
+            Header->cmsg_type = SCM_RIGHTS;
+            Header->cmsg_len = CMSG_LEN(Sender->HandleCount * sizeof(int));
+            memcpy(CMSG_DATA(Header), Sender->Handles, Sender->HandleCount * sizeof(int));
+        }
+        sendmsg(Connection, &Message, MSG_NOSIGNAL);
+        close(Connection);
+    }
+    return NULL;
+}
+
+// Publishes Size bytes under Prefix + Name until SharedTexture_StopSend. File
+// descriptors can't be looked up by number from another process, so the listed
+// ones travel alongside the data.
+static shared_texture_sender *SharedTexture_Send(const char *Prefix, const char *Name, const void *Data, uint32_t Size,
+                                                 uint32_t HandleCount, const shared_handle *Handles)
+{
+    struct sockaddr_un Address;
+    socklen_t AddressLength = SharedTexture_SocketAddress(&Address, Prefix, Name);
+    int Socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (Socket < 0) return NULL;
+    if (bind(Socket, (struct sockaddr *)&Address, AddressLength) != 0 || listen(Socket, SOMAXCONN) != 0)
+    {
+        close(Socket);
+        return NULL;
+    }
+
+    shared_texture_sender *Sender = calloc(1, sizeof(shared_texture_sender) + Size);
+    if (!Sender)
+    {
+        close(Socket);
+        return NULL;
+    }
+    Sender->Socket = Socket;
+    Sender->Size = Size;
+    memcpy(Sender->Data, Data, Size);
+    // The caller may close its handles while consumers still connect.
+    for (uint32_t i = 0; i < HandleCount && Sender->HandleCount < SEND_MAX_HANDLES; ++i)
+        if (Handles[i] >= 0)
+            Sender->Handles[Sender->HandleCount++] = fcntl(Handles[i], F_DUPFD_CLOEXEC, 0);
+
+    if (pthread_create(&Sender->Thread, NULL, SharedTexture_SendThreadProc, Sender) != 0)
+    {
+        for (uint32_t i = 0; i < Sender->HandleCount; ++i)
+            close(Sender->Handles[i]);
+        close(Socket);
+        free(Sender);
+        return NULL;
+    }
+    return Sender;
+}
+
+// Stops serving and drops the duplicated descriptors, so they no longer keep
+// the memory alive.
+static void SharedTexture_StopSend(shared_texture_sender *Sender)
+{
+    if (!Sender) return;
+    // Wakes the thread up in accept.
+    shutdown(Sender->Socket, SHUT_RDWR);
+    pthread_join(Sender->Thread, NULL);
+    for (uint32_t i = 0; i < Sender->HandleCount; ++i)
+        close(Sender->Handles[i]);
+    close(Sender->Socket);
+    free(Sender);
+}
+
+// Reads Size bytes published under Prefix + Name. The received descriptors
+// replace the listed handles, which point into Data, in order. Handles that
+// were -1 on the sending side are skipped.
+static bool SharedTexture_Receive(const char *Prefix, const char *Name, void *Data, uint32_t Size,
+                                  uint32_t HandleCount, shared_handle **Handles)
+{
+    struct sockaddr_un Address;
+    socklen_t AddressLength = SharedTexture_SocketAddress(&Address, Prefix, Name);
+    int Socket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (Socket < 0) return false;
+    if (connect(Socket, (struct sockaddr *)&Address, AddressLength) != 0)
+    {
+        close(Socket);
+        return false;
+    }
+
+    char ControlData[CMSG_SPACE(SEND_MAX_HANDLES * sizeof(int))];
+    struct iovec Vector = { .iov_base = Data, .iov_len = Size };
+    struct msghdr Message = {
+        .msg_iov = &Vector,
+        .msg_iovlen = 1,
+        .msg_control = ControlData,
+        .msg_controllen = sizeof(ControlData),
+    };
+    ssize_t Received = recvmsg(Socket, &Message, MSG_CMSG_CLOEXEC);
+    close(Socket);
+    if (Received != (ssize_t)Size)
+        return false;
+
+    int ReceivedHandles[SEND_MAX_HANDLES];
+    uint32_t ReceivedCount = 0;
+    for (struct cmsghdr *Header = CMSG_FIRSTHDR(&Message); Header; Header = CMSG_NXTHDR(&Message, Header))
+    {
+        if (Header->cmsg_level != SOL_SOCKET || Header->cmsg_type != SCM_RIGHTS)
+            continue;
+        ReceivedCount = (Header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(ReceivedHandles, CMSG_DATA(Header), ReceivedCount * sizeof(int));
+    }
+
+    uint32_t Next = 0;
+    for (uint32_t i = 0; i < HandleCount; ++i)
+        if (*Handles[i] >= 0)
+            *Handles[i] = Next < ReceivedCount ? ReceivedHandles[Next++] : -1;
+    return true;
+}
+
+#define CONTROL_PREFIX "/shared_texture_"
+
+// Unlike Windows mappings, the object outlives its last user. A stale one
+// only carries an old generation, which the next producer counts up from.
+static shared_texture_control *SharedTexture_MapControl(const char *Name, bool Create, int *Mapping)
+{
+    char MappingName[NAME_MAX] = { 0 };
+    snprintf(MappingName, NAME_MAX, "%s%s", CONTROL_PREFIX, Name);
+    *Mapping = shm_open(MappingName, Create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+    if (*Mapping < 0) return NULL;
+    if (Create && ftruncate(*Mapping, sizeof(shared_texture_control)) != 0)
+    {
+        close(*Mapping);
+        *Mapping = -1;
+        return NULL;
+    }
+
+    shared_texture_control *Control = mmap(NULL, sizeof(shared_texture_control), PROT_READ | PROT_WRITE, MAP_SHARED, *Mapping, 0);
+    if (Control == MAP_FAILED)
+    {
+        close(*Mapping);
+        *Mapping = -1;
+        return NULL;
+    }
+    return Control;
+}
+
+static void SharedTexture_UnmapControl(shared_texture_control *Control, int Mapping)
+{
+    if (Control) munmap(Control, sizeof(shared_texture_control));
+    if (Mapping >= 0) close(Mapping);
+}
+
+static void SharedTexture_StoreGeneration(shared_texture_control *Control, int64_t Generation)
+{
+    __atomic_store_n(&Control->Generation, Generation, __ATOMIC_RELEASE);
+}
+
+static void SharedTexture_AddUsage(shared_texture_control *Control, uint32_t Usage)
+{
+    __atomic_fetch_or(&Control->Usage, (int32_t)Usage, __ATOMIC_RELEASE);
+}
+
+static void SharedTexture_CloseHandle(int Handle)
+{
+    if (Handle >= 0) close(Handle);
+}
+
+#define CPU_HUGE_PAGE_SIZE (2ull << 20)
+
+// Maps the memory once before anyone touches it. hugetlbfs takes its page
+// reservation here, so a lack of huge pages shows now and not in SharedTexture_Map.
+// With a NUMA node every page is faulted in under that policy, which keeps
+// them there no matter who touches them later.
+static bool SharedTexture_PlaceCpuMemory(int Memory, uint64_t Size, uint32_t NumaNode)
+{
+    void *Data = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Memory, 0);
+    if (Data == MAP_FAILED)
+        return false;
+    if (NumaNode && NumaNode <= 1024)
+    {
+        unsigned long Mask[1024 / (8 * sizeof(unsigned long))] = { 0 };
+        Mask[(NumaNode - 1) / (8 * sizeof(unsigned long))] = 1ul << ((NumaNode - 1) % (8 * sizeof(unsigned long)));
+        if (Size >= CPU_HUGE_PAGE_SIZE)
+            madvise(Data, Size, MADV_HUGEPAGE);
+        syscall(SYS_mbind, Data, Size, MPOL_PREFERRED, Mask, 8 * sizeof(Mask), 0);
+        memset(Data, 0, Size);
+    }
+    munmap(Data, Size);
+    return true;
+}
+
+// CPU textures live in a memfd, the semaphore is a futex in the control block.
+// Large ones take huge pages if hugetlbfs has some reserved, and otherwise
+// ask for transparent huge pages when mapped.
+static int SharedTexture_CreateCpuMemory(shared_texture *SharedTexture)
+{
+    if (SharedTexture->Size >= CPU_HUGE_PAGE_SIZE)
+    {
+        uint64_t Size = (SharedTexture->Size + CPU_HUGE_PAGE_SIZE - 1) & ~(CPU_HUGE_PAGE_SIZE - 1);
+        int Memory = memfd_create("shared_texture", MFD_CLOEXEC | MFD_HUGETLB);
+        if (Memory >= 0 && ftruncate(Memory, (off_t)Size) == 0 && SharedTexture_PlaceCpuMemory(Memory, Size, SharedTexture->NumaNode))
+        {
+            SharedTexture->Size = Size;
+            SharedTexture->Flags |= SHARED_TEXTURE_FLAG_HUGE_PAGES;
+            return Memory;
+        }
+        if (Memory >= 0)
+            close(Memory);
+    }
+
+    int Memory = memfd_create("shared_texture", MFD_CLOEXEC);
+    if (Memory >= 0 && (ftruncate(Memory, (off_t)SharedTexture->Size) != 0 ||
+                        !SharedTexture_PlaceCpuMemory(Memory, SharedTexture->Size, SharedTexture->NumaNode)))
+    {
+        close(Memory);
+        return -1;
+    }
+    return Memory;
+}
+
+static uint8_t *SharedTexture_MapCpuMemory(shared_texture SharedTexture)
+{
+    void *Data = mmap(NULL, SharedTexture.Size, PROT_READ | PROT_WRITE, MAP_SHARED, SHARED_HANDLE(SharedTexture, MemoryHandle), 0);
+    if (Data == MAP_FAILED)
+        return NULL;
+    if (!(SharedTexture.Flags & SHARED_TEXTURE_FLAG_HUGE_PAGES) && SharedTexture.Size >= CPU_HUGE_PAGE_SIZE)
+        madvise(Data, SharedTexture.Size, MADV_HUGEPAGE);
+    return Data;
+}
+
+static void SharedTexture_UnmapCpuMemory(uint8_t *Data, uint64_t Size)
+{
+    munmap(Data, Size);
+}
+
+static int SharedTexture_CreateCpuSemaphore(void)
+{
+    return -1;
+}
+
+// Binary like the Vulkan semaphores it replaces: whoever swaps the 1 back to 0
+// took the signal, everyone else sleeps until the next one.
+static void SharedTexture_CpuWait(shared_texture_control *Control, int Semaphore)
+{
+    while (!__atomic_exchange_n(&Control->CpuSignal, 0, __ATOMIC_ACQUIRE))
+        syscall(SYS_futex, &Control->CpuSignal, FUTEX_WAIT, 0, NULL, NULL, 0);
+}
+
+static void SharedTexture_CpuSignal(shared_texture_control *Control, int Semaphore)
+{
+    __atomic_store_n(&Control->CpuSignal, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &Control->CpuSignal, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
 #endif
 
+static void SharedTexture_CloseHandles(shared_texture SharedTexture);
+
+// Every generation of a shared texture is published under its own pipe, so a
+// resize never has to wait for consumers of the previous one to connect.
+static void SharedTexture_GenerationName(char *Buffer, size_t BufferSize, const char *Name, int64_t Generation)
+{
+    snprintf(Buffer, BufferSize, "%s.%lld", Name, (long long)Generation);
+}
+
 //
 // VULKAN
 //
@@ -95,17 +575,51 @@ struct
     VkInstance Instance;
     VkPhysicalDevice PhysicalDevice;
     VkDevice Device;
+    vk_device_funcs Funcs;  // of Device, the globals are left to the functions in share.h
+    VkQueue Queue;
+    uint32_t QueueFamilyIndex;
+    VkQueue TransferQueue;  // of another family than Queue, transfer only if there is one, or VK_NULL_HANDLE
+    uint32_t TransferQueueFamilyIndex;
+    bool AsyncTransfer;     // see SharedTexture_SetAsyncTransfer
+    bool Borrowed;          // Instance and Device belong to the application, see SharedTexture_InitWithDevice
+    bool Lazy;              // see SharedTexture_InitLazy
+    bool CpuFallback;       // see SharedTexture_SetCpuFallback
+    bool DmaBuf;            // VK_EXT_external_memory_dma_buf and VK_EXT_image_drm_format_modifier
+    bool HostPointer;       // VK_EXT_external_memory_host
+    VkDeviceSize HostPointerAlignment;
 } VK;
 
-bool SHARED_TEXTURE_EXPORT SharedTexture_Init(void)
+static bool SharedTexture_LoadVulkan(void)
 {
 #if _WIN32
     HMODULE VulkanDLL = LoadLibraryA("vulkan-1.dll");
     if (!VulkanDLL) return false;
     vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)GetProcAddress(VulkanDLL, "vkGetInstanceProcAddr");
+#else
+    void *VulkanLibrary = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!VulkanLibrary) return false;
+    vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)dlsym(VulkanLibrary, "vkGetInstanceProcAddr");
 #endif
+    return vkGetInstanceProcAddr != NULL;
+}
+
+static VkDeviceSize SharedTexture_HostPointerAlignment(VkPhysicalDevice PhysicalDevice)
+{
+    VkPhysicalDeviceExternalMemoryHostPropertiesEXT HostProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT,
+    };
+    vkGetPhysicalDeviceProperties2(PhysicalDevice,
+        &(VkPhysicalDeviceProperties2) {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &HostProperties,
+        }
+    );
+    return HostProperties.minImportedHostPointerAlignment;
+}
 
-    if (!VK_LoadFunctions())
+static bool SharedTexture_InitVulkan(void)
+{
+    if (!SharedTexture_LoadVulkan() || !VK_LoadFunctions())
         return false;
 
     VK.Instance = VK_NULL_HANDLE;
@@ -137,17 +651,43 @@ bool SHARED_TEXTURE_EXPORT SharedTexture_Init(void)
     const char* ExtNames[] = {
 #if defined(_WIN32)
         VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME,
-        VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME
+        VK_KHR_EXTERNAL_SEMAPHORE_WIN32_EXTENSION_NAME,
 #else
         VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
-        VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME
+        VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME,
+        // optional, must stay last
+        VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+        VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME,
 #endif
+        // optional
+        VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME,
     };
-    const uint32_t ExtCount = sizeof(ExtNames) / sizeof(ExtNames[0]);
+    uint32_t ExtCount = sizeof(ExtNames) / sizeof(ExtNames[0]) - 1;
+#if !defined(_WIN32)
+    const uint32_t OptionalExtCount = 2;
+    ExtCount -= OptionalExtCount;
+#endif
 
     VK.PhysicalDevice = Vulkan_FindPhysicalDevice(VK.Instance, VK_NULL_HANDLE, ExtCount, ExtNames);
     if (VK.PhysicalDevice == VK_NULL_HANDLE) return false;
+#if !defined(_WIN32)
+    VK.DmaBuf = Vulkan_CheckDeviceExtensions(VK.PhysicalDevice, OptionalExtCount, ExtNames + ExtCount);
+    if (VK.DmaBuf)
+        ExtCount += OptionalExtCount;
+    else
+        ExtNames[ExtCount] = ExtNames[ExtCount + OptionalExtCount];
+#endif
+    const char *HostPointerExtName = VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME;
+    VK.HostPointer = Vulkan_CheckDeviceExtensions(VK.PhysicalDevice, 1, &HostPointerExtName);
+    if (VK.HostPointer)
+    {
+        VK.HostPointerAlignment = SharedTexture_HostPointerAlignment(VK.PhysicalDevice);
+        ExtCount++;
+    }
     uint32_t QueueIndex = Vulkan_DefaultQueueFamilyIndex(VK.PhysicalDevice, VK_NULL_HANDLE);
+    // Falls back to a graphics or compute family if there is no transfer only one.
+    int32_t TransferQueueIndex = Vulkan_TransferQueueFamilyIndex(VK.PhysicalDevice);
+    bool Transfer = TransferQueueIndex >= 0 && (uint32_t)TransferQueueIndex != QueueIndex;
 
     Result = vkCreateDevice(VK.PhysicalDevice,
         &(VkDeviceCreateInfo) {
@@ -159,169 +699,1653 @@ bool SHARED_TEXTURE_EXPORT SharedTexture_Init(void)
                         .queueCount = 1,
                         .pQueuePriorities = (float[]){ 1.0f }
                     },
+                    [1] = {
+                        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                        .queueFamilyIndex = (uint32_t)TransferQueueIndex,
+                        .queueCount = 1,
+                        .pQueuePriorities = (float[]){ 1.0f }
+                    },
                 },
-            .queueCreateInfoCount = 1,
+            .queueCreateInfoCount = Transfer ? 2 : 1,
             .enabledExtensionCount = ExtCount,
             .ppEnabledExtensionNames = ExtNames,
             .pEnabledFeatures = 0,
+            // Timeline semaphores track the readback ring of SharedRecorder_Record.
+            .pNext = &(VkPhysicalDeviceVulkan12Features) {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .timelineSemaphore = VK_TRUE,
+            },
         },
         0, &VK.Device
     );
     if (Result != VK_SUCCESS)
         return false;
+    if (!VK_LoadDeviceFunctions(&VK.Funcs, vkGetDeviceProcAddr, VK.Device))
+        return false;
 
+    VK.Funcs.vkGetDeviceQueue(VK.Device, QueueIndex, 0, &VK.Queue);
+    VK.QueueFamilyIndex = QueueIndex;
+    VK.TransferQueue = VK_NULL_HANDLE;
+    if (Transfer)
+    {
+        VK.Funcs.vkGetDeviceQueue(VK.Device, (uint32_t)TransferQueueIndex, 0, &VK.TransferQueue);
+        VK.TransferQueueFamilyIndex = (uint32_t)TransferQueueIndex;
+    }
     return true;
 }
 
-shared_texture SHARED_TEXTURE_EXPORT SharedTexture_Open(const char *Name)
+// Queue of the library's own copies. They only touch the shared image, which
+// every queue acquires from and releases to VK_QUEUE_FAMILY_EXTERNAL, and
+// buffers of the library, so no transfer between the two queues is needed.
+static VkQueue SharedTexture_CopyQueue(uint32_t *QueueFamilyIndex)
 {
-    shared_texture SharedTexture = { 0 };
-    if(SharedTexture_Receive(&SharedTexture, Name))
-        return SharedTexture;
-
-    return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    if (VK.AsyncTransfer)
+    {
+        *QueueFamilyIndex = VK.TransferQueueFamilyIndex;
+        return VK.TransferQueue;
+    }
+    *QueueFamilyIndex = VK.QueueFamilyIndex;
+    return VK.Queue;
 }
 
-shared_texture SHARED_TEXTURE_EXPORT SharedTexture_Create(const char *Name, int32_t Width, int32_t Height, shared_texture_format Format)
+static bool SharedTexture_InitVulkanOrCpu(void)
 {
-    // IMAGE
-    VkImage Image;
-    vkCreateImage(VK.Device,
-        &(VkImageCreateInfo){
-            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-            .pNext = &(VkExternalMemoryImageCreateInfo){
-                .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
-                .handleTypes = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE
-            },
-            .flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT,
-            .imageType = VK_IMAGE_TYPE_2D,
-            .format = SharedTexture_ToVulkanFormat(Format),
-            .extent = {
-                .width = Width,
-                .height = Height,
-                .depth = 1,
-            },
-            .mipLevels = 1,
-            .arrayLayers = 1,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | 
-                     VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            .queueFamilyIndexCount = 0,
-            .pQueueFamilyIndices = 0,
-            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        },
-        0, &Image
-    );
+    if (SharedTexture_InitVulkan())
+        return true;
+    VK.Device = VK_NULL_HANDLE;
+    VK.Queue = VK_NULL_HANDLE;
+    VK.TransferQueue = VK_NULL_HANDLE;
+    VK.DmaBuf = false;
+    VK.HostPointer = false;
+    return false;
+}
 
-    // MEMORY
-    VkDeviceMemory Memory;
-    VkMemoryRequirements MemReqs;
-    vkGetImageMemoryRequirements(VK.Device, Image, &MemReqs);
-    uint32_t MemoryTypeIndex = Vulkan_FindPhysicalDeviceMemoryIndex(VK.PhysicalDevice,
-        MemReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    vkAllocateMemory(VK.Device,
-        &(VkMemoryAllocateInfo) {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-            .pNext = &(VkExportMemoryAllocateInfo){
-                .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
-                .handleTypes = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE
-            },
-            .allocationSize = MemReqs.size,
-            .memoryTypeIndex = MemoryTypeIndex,
-        },
-        0, &Memory
-    );
+#if defined(_WIN32)
 
-    // SEMAPHORE
-    VkSemaphore Semaphore;
-    vkCreateSemaphore(VK.Device,
-        &(VkSemaphoreCreateInfo) {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-            .pNext = &(VkExportSemaphoreCreateInfo){
-                .sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
-                .handleTypes = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE
-            },
-        },
-        0, &Semaphore
-    );
+static INIT_ONCE SharedTexture_LazyOnce = INIT_ONCE_STATIC_INIT;
 
-#if defined(_WIN32)
-    HANDLE Win32MemoryHandle;
-    vkGetMemoryWin32HandleKHR(VK.Device,
-        &(VkMemoryGetWin32HandleInfoKHR) {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR,
-            .memory = Memory,
-            .handleType = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE 
-        }, &Win32MemoryHandle
-    );
+static BOOL CALLBACK SharedTexture_LazyInitOnce(PINIT_ONCE Once, PVOID Parameter, PVOID *Context)
+{
+    SharedTexture_InitVulkanOrCpu();
+    return TRUE;
+}
 
-    HANDLE Win32SemaphoreHandle;
-    vkGetSemaphoreWin32HandleKHR(VK.Device,
-        &(VkSemaphoreGetWin32HandleInfoKHR) {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_WIN32_HANDLE_INFO_KHR,
-            .semaphore = Semaphore,
-            .handleType = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE,
-        }, &Win32SemaphoreHandle
-    );
 #else
-    int PosixMemoryHandle;
-    vkGetMemoryFdKHR(VK.Device,
-        &(VkMemoryGetFdInfoKHR) {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR,
-            .memory = Memory,
-            .handleType = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE 
-        }, &PosixMemoryHandle
-    );
 
-    int PosixSemaphoreHandle;
-    vkGetSemaphoreFdKHR(VK.Device,
-        &(VkSemaphoreGetFdInfoKHR) {
-            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_WIN32_HANDLE_INFO_KHR,
-            .semaphore = Semaphore,
-            .handleType = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE,
-        }, &PosixSemaphoreHandle
-    );
-#endif
+static pthread_once_t SharedTexture_LazyOnce = PTHREAD_ONCE_INIT;
 
-    vkFreeMemory(VK.Device, Memory, 0);
-    vkDestroyImage(VK.Device, Image, 0);
-    vkDestroySemaphore(VK.Device, Semaphore, 0);
+static void SharedTexture_LazyInitOnce(void)
+{
+    SharedTexture_InitVulkanOrCpu();
+}
 
-    shared_texture SharedTexture = {
-        .Format = Format,
-        .Width = Width,
-        .Height = Height,
-        .Size = MemReqs.size,
-    #if defined(_WIN32)
-        .Win32 = {
-            .MemoryHandle = Win32MemoryHandle,
-            .SemaphoreHandle = Win32SemaphoreHandle,
-        }
-    #else
-        .Posix = {
-            .MemoryHandle = PosixMemoryHandle,
-            .SemaphoreHandle = PosixSemaphoreHandle,
-        }
-    #endif
-    };
+#endif
 
-    if (SharedTexture_Send(SharedTexture, Name))
-        return SharedTexture;
+// Creates the private device of SharedTexture_InitLazy on first use. Returns
+// false on the CPU backend.
+static bool SharedTexture_RequireDevice(void)
+{
+    if (VK.Lazy)
+    {
+#if defined(_WIN32)
+        InitOnceExecuteOnce(&SharedTexture_LazyOnce, SharedTexture_LazyInitOnce, NULL, NULL);
+#else
+        pthread_once(&SharedTexture_LazyOnce, SharedTexture_LazyInitOnce);
+#endif
+    }
+    return VK.Device != VK_NULL_HANDLE;
+}
 
-    SharedTexture_Close(SharedTexture);
-    return (shared_texture) { .Format = SHARED_TEXTURE_NONE };    
+// GPU-less hosts still run the whole producer/consumer pipeline on CPU
+// textures, if the application opted in.
+bool SHARED_TEXTURE_EXPORT SharedTexture_Init(void)
+{
+    return SharedTexture_InitVulkanOrCpu() || VK.CpuFallback;
 }
 
-void SHARED_TEXTURE_EXPORT SharedTexture_Close(shared_texture SharedTexture)
+bool SHARED_TEXTURE_EXPORT SharedTexture_InitLazy(void)
 {
-#if _WIN32
-    CloseHandle(SharedTexture.Win32.MemoryHandle);
-    CloseHandle(SharedTexture.Win32.SemaphoreHandle);
+    VK.Lazy = true;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_InitWithDevice(VkInstance Instance, VkPhysicalDevice PhysicalDevice, VkDevice Device,
+                                                         PFN_vkGetInstanceProcAddr GetInstanceProcAddr)
+{
+    // A device of the library's own may already back mappings and readbacks,
+    // it is not swapped out from under them.
+    if (VK.Device != VK_NULL_HANDLE && !VK.Borrowed)
+        return false;
+    if (GetInstanceProcAddr)
+        vkGetInstanceProcAddr = GetInstanceProcAddr;
+    else if (!SharedTexture_LoadVulkan())
+        return false;
+    vk_device_funcs Funcs;
+    if (!VK_LoadInstanceFunctions(Instance) || !VK_LoadDeviceFunctions(&Funcs, vkGetDeviceProcAddr, Device))
+        return false;
+
+    // Extension commands are only there if the application enabled them.
+#if defined(_WIN32)
+    if (!Funcs.vkGetMemoryWin32HandleKHR || !Funcs.vkGetSemaphoreWin32HandleKHR)
+        return false;
+    VK.DmaBuf = false;
 #else
-  #error posix not implemented
+    if (!Funcs.vkGetMemoryFdKHR || !Funcs.vkGetSemaphoreFdKHR)
+        return false;
+    VK.DmaBuf = Funcs.vkGetImageDrmFormatModifierPropertiesEXT != NULL;
 #endif
+    VK.HostPointer = Funcs.vkGetMemoryHostPointerPropertiesEXT != NULL;
+    if (VK.HostPointer)
+        VK.HostPointerAlignment = SharedTexture_HostPointerAlignment(PhysicalDevice);
+
+    VK.Instance = Instance;
+    VK.PhysicalDevice = PhysicalDevice;
+    VK.Device = Device;
+    VK.Funcs = Funcs;
+    VK.Queue = VK_NULL_HANDLE;
+    VK.TransferQueue = VK_NULL_HANDLE;
+    VK.AsyncTransfer = false;
+    VK.Borrowed = true;
+    VK.Lazy = false;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetDeviceQueue(VkQueue Queue, uint32_t QueueFamilyIndex)
+{
+    if (!VK.Borrowed || VK.Device == VK_NULL_HANDLE)
+        return false;
+    VK.Queue = Queue;
+    VK.QueueFamilyIndex = QueueFamilyIndex;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_HasDevice(void)
+{
+    return SharedTexture_RequireDevice();
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetAsyncTransfer(bool Enable)
+{
+    if (Enable && (!SharedTexture_RequireDevice() || VK.TransferQueue == VK_NULL_HANDLE))
+        return false;
+    VK.AsyncTransfer = Enable;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetCpuFallback(bool Enable)
+{
+    VK.CpuFallback = Enable;
+    return true;
+}
+
+static bool SharedTexture_ReceiveGeneration(shared_texture *SharedTexture, const char *Name, int64_t Generation)
+{
+    char GenerationName[MAX_PATH];
+    SharedTexture_GenerationName(GenerationName, sizeof(GenerationName), Name, Generation);
+
+    *SharedTexture = (shared_texture) { 0 };
+    shared_handle *Handles[] = { &SHARED_HANDLE(*SharedTexture, MemoryHandle), &SHARED_HANDLE(*SharedTexture, SemaphoreHandle) };
+    if (!SharedTexture_Receive(PIPE_PREFIX, GenerationName, SharedTexture, sizeof(shared_texture), 2, Handles))
+        return false;
+    SharedTexture->Sender = NULL;
+    return true;
+}
+
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_Open(const char *Name)
+{
+    shared_handle ControlHandle;
+    shared_texture_control *Control = SharedTexture_MapControl(Name, false, &ControlHandle);
+    if (!Control)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    // A resize may stop serving the generation read here before it is received.
+    shared_texture SharedTexture;
+    int64_t Generation = Control->Generation;
+    bool Received;
+    while (!(Received = SharedTexture_ReceiveGeneration(&SharedTexture, Name, Generation)) && Generation != Control->Generation)
+        Generation = Control->Generation;
+    if (!Received)
+    {
+        SharedTexture_UnmapControl(Control, ControlHandle);
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    }
+
+    SharedTexture.Control = Control;
+    SHARED_HANDLE(SharedTexture, ControlHandle) = ControlHandle;
+    return SharedTexture;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_Reopen(shared_texture *SharedTexture, const char *Name)
+{
+    if (!SharedTexture->Control)
+        return false;
+
+    int64_t Generation = SharedTexture->Control->Generation;
+    if (Generation == SharedTexture->Generation)
+        return false;
+
+    shared_texture Next;
+    if (!SharedTexture_ReceiveGeneration(&Next, Name, Generation))
+        return false;
+
+    // Imports made from the old handles keep the old storage alive on their own.
+    SharedTexture_CloseHandles(*SharedTexture);
+    Next.Control = SharedTexture->Control;
+    SHARED_HANDLE(Next, ControlHandle) = SHARED_HANDLE(*SharedTexture, ControlHandle);
+    *SharedTexture = Next;
+    return true;
+}
+
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_Create(const char *Name, int32_t Width, int32_t Height, shared_texture_format Format)
+{
+    return SharedTexture_CreateEx(Name,
+        &(shared_texture_create_info) {
+            .Type = SHARED_TEXTURE_2D,
+            .Format = Format,
+            .Width = Width,
+            .Height = Height,
+        }
+    );
+}
+
+static shared_texture SharedTexture_FromCreateInfo(const shared_texture_create_info *CreateInfo)
+{
+    shared_texture SharedTexture = {
+        .Format = CreateInfo->Format,
+        .Width = CreateInfo->Width,
+        .Height = CreateInfo->Height,
+        .Type = CreateInfo->Type,
+        .Depth = 1,
+        .Layers = 1,
+        .Flags = CreateInfo->Flags & (SHARED_TEXTURE_FLAG_DMA_BUF | SHARED_TEXTURE_FLAG_HOST | SHARED_TEXTURE_FLAG_CPU),
+        .Usage = CreateInfo->Usage ? CreateInfo->Usage : SHARED_TEXTURE_USAGE_DEFAULT,
+        .ViewFormats = CreateInfo->ViewFormats & ~SHARED_TEXTURE_FORMAT_BIT(CreateInfo->Format),
+        .Primaries = CreateInfo->Primaries,
+        .Transfer = CreateInfo->Transfer,
+        .Samples = CreateInfo->Samples > 1 ? CreateInfo->Samples : 1,
+        .ResolveSlots = CreateInfo->ResolveSlots,
+        .NumaNode = CreateInfo->NumaNode,
+    };
+    SHARED_HANDLE(SharedTexture, MemoryHandle) = SHARED_HANDLE_NONE;
+    SHARED_HANDLE(SharedTexture, SemaphoreHandle) = SHARED_HANDLE_NONE;
+    SHARED_HANDLE(SharedTexture, ControlHandle) = SHARED_HANDLE_NONE;
+
+    if ((SharedTexture.Flags & SHARED_TEXTURE_FLAG_HOST) &&
+        (CreateInfo->Type != SHARED_TEXTURE_2D || (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF)))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    // Without a device every texture is a CPU texture, if that was asked for.
+    if (!(SharedTexture.Flags & SHARED_TEXTURE_FLAG_CPU) && !SharedTexture_RequireDevice())
+    {
+        if (!VK.CpuFallback)
+            return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+        SharedTexture.Flags |= SHARED_TEXTURE_FLAG_CPU;
+    }
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_CPU)
+    {
+        if (CreateInfo->Type != SHARED_TEXTURE_2D || (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF) ||
+            SharedTexture.Samples > 1 || !SharedTexture_CpuTexelSize(SharedTexture.Format))
+            return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+        SharedTexture.Flags |= SHARED_TEXTURE_FLAG_HOST;
+    }
+
+#if defined(_WIN32)
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+#else
+    if ((SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF) && (!VK.DmaBuf || CreateInfo->Type != SHARED_TEXTURE_2D))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+#endif
+
+    if (SharedTexture.Primaries > SHARED_TEXTURE_PRIMARIES_BT2020 || SharedTexture.Transfer > SHARED_TEXTURE_TRANSFER_HLG ||
+        (SharedTexture.Format == SHARED_TEXTURE_RGBA8_SRGB && SharedTexture.Transfer != SHARED_TEXTURE_TRANSFER_SRGB))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    if (SharedTexture.Samples > 1 &&
+        ((SharedTexture.Samples != 2 && SharedTexture.Samples != 4 && SharedTexture.Samples != 8) ||
+         CreateInfo->Type != SHARED_TEXTURE_2D || SharedTexture.Flags || SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format)))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    if (SharedTexture.ResolveSlots)
+    {
+        if (SharedTexture.Samples == 1 || SharedTexture.Format == SHARED_TEXTURE_DEPTH)
+            return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+        SharedTexture.Usage |= SHARED_TEXTURE_USAGE_TRANSFER_SRC;
+    }
+
+    if (SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format))
+    {
+        if (CreateInfo->Type != SHARED_TEXTURE_2D || (SharedTexture.Width | SharedTexture.Height) & 1 ||
+            (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF))
+            return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+        SharedTexture.Usage &= SHARED_TEXTURE_USAGE_SAMPLED | SHARED_TEXTURE_USAGE_TRANSFER_SRC | SHARED_TEXTURE_USAGE_TRANSFER_DST;
+        if (!SharedTexture.Usage)
+            SharedTexture.Usage = SHARED_TEXTURE_USAGE_SAMPLED;
+    }
+
+    // Views can only reinterpret texels of the same size and kind.
+    const uint32_t ColorFormats = SHARED_TEXTURE_FORMAT_BIT(SHARED_TEXTURE_RGBA8) |
+        SHARED_TEXTURE_FORMAT_BIT(SHARED_TEXTURE_RGBA8_SRGB) | SHARED_TEXTURE_FORMAT_BIT(SHARED_TEXTURE_RGBA8_UINT);
+    if (SharedTexture.ViewFormats &&
+        ((SharedTexture.ViewFormats & ~ColorFormats) || !(ColorFormats & SHARED_TEXTURE_FORMAT_BIT(SharedTexture.Format))))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    switch (CreateInfo->Type)
+    {
+        case SHARED_TEXTURE_2D:
+            break;
+        case SHARED_TEXTURE_2D_ARRAY:
+            SharedTexture.Layers = CreateInfo->Layers ? CreateInfo->Layers : 1;
+            break;
+        case SHARED_TEXTURE_CUBE:
+            SharedTexture.Layers = CreateInfo->Layers ? CreateInfo->Layers : 6;
+            if (SharedTexture.Layers % 6 || SharedTexture.Width != SharedTexture.Height)
+                return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+            break;
+        case SHARED_TEXTURE_3D:
+            SharedTexture.Depth = CreateInfo->Depth ? CreateInfo->Depth : 1;
+            break;
+        default:
+            return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    }
+    return SharedTexture;
+}
+
+// dma-buf images let the driver pick one of Modifiers, the others are laid out as usual.
+static VkImage SharedTexture_CreateVulkanImage(shared_texture SharedTexture, uint32_t ModifierCount, const uint64_t *Modifiers)
+{
+    VkImage Image = VK_NULL_HANDLE;
+    vk_shared_format_list FormatList;
+    VkImageCreateInfo ImageCreateInfo = SharedTexture_ToVulkanImageCreateInfo(SharedTexture,
+        SharedTexture_ToVulkanFormatList(SharedTexture, &FormatList, &(VkExternalMemoryImageCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+            .pNext = (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF) ? &(VkImageDrmFormatModifierListCreateInfoEXT) {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_LIST_CREATE_INFO_EXT,
+                .drmFormatModifierCount = ModifierCount,
+                .pDrmFormatModifiers = Modifiers,
+            } : 0,
+            .handleTypes = SharedTexture_ToVulkanHandleType(SharedTexture)
+        })
+    );
+    if (VK.Funcs.vkCreateImage(VK.Device, &ImageCreateInfo, 0, &Image) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    return Image;
+}
+
+static VkDeviceMemory SharedTexture_AllocateExportableMemory(VkDeviceSize Size, uint32_t MemoryTypeIndex, VkImage DedicatedImage,
+                                                             VkExternalMemoryHandleTypeFlagBits HandleType)
+{
+    VkDeviceMemory Memory = VK_NULL_HANDLE;
+    VK.Funcs.vkAllocateMemory(VK.Device,
+        &(VkMemoryAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = &(VkExportMemoryAllocateInfo){
+                .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+                .pNext = DedicatedImage == VK_NULL_HANDLE ? 0 : &(VkMemoryDedicatedAllocateInfo) {
+                    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+                    .image = DedicatedImage,
+                },
+                .handleTypes = HandleType
+            },
+            .allocationSize = Size,
+            .memoryTypeIndex = MemoryTypeIndex,
+        },
+        0, &Memory
+    );
+    return Memory;
+}
+
+#if defined(_WIN32)
+
+static shared_handle SharedTexture_ExportMemory(VkDeviceMemory Memory, VkExternalMemoryHandleTypeFlagBits HandleType)
+{
+    HANDLE Win32MemoryHandle = NULL;
+    VK.Funcs.vkGetMemoryWin32HandleKHR(VK.Device,
+        &(VkMemoryGetWin32HandleInfoKHR) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR,
+            .memory = Memory,
+            .handleType = HandleType
+        }, &Win32MemoryHandle
+    );
+    return Win32MemoryHandle;
+}
+
+static shared_handle SharedTexture_ExportSemaphore(VkSemaphore Semaphore)
+{
+    HANDLE Win32SemaphoreHandle = NULL;
+    VK.Funcs.vkGetSemaphoreWin32HandleKHR(VK.Device,
+        &(VkSemaphoreGetWin32HandleInfoKHR) {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_WIN32_HANDLE_INFO_KHR,
+            .semaphore = Semaphore,
+            .handleType = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE,
+        }, &Win32SemaphoreHandle
+    );
+    return Win32SemaphoreHandle;
+}
+
+#else
+
+static shared_handle SharedTexture_ExportMemory(VkDeviceMemory Memory, VkExternalMemoryHandleTypeFlagBits HandleType)
+{
+    int PosixMemoryHandle = -1;
+    VK.Funcs.vkGetMemoryFdKHR(VK.Device,
+        &(VkMemoryGetFdInfoKHR) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+            .memory = Memory,
+            .handleType = HandleType
+        }, &PosixMemoryHandle
+    );
+    return PosixMemoryHandle;
+}
+
+static shared_handle SharedTexture_ExportSemaphore(VkSemaphore Semaphore)
+{
+    int PosixSemaphoreHandle = -1;
+    VK.Funcs.vkGetSemaphoreFdKHR(VK.Device,
+        &(VkSemaphoreGetFdInfoKHR) {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR,
+            .semaphore = Semaphore,
+            .handleType = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE,
+        }, &PosixSemaphoreHandle
+    );
+    return PosixSemaphoreHandle;
+}
+
+#endif
+
+static shared_handle SharedTexture_CreateSemaphore(void)
+{
+    VkSemaphore Semaphore;
+    VK.Funcs.vkCreateSemaphore(VK.Device,
+        &(VkSemaphoreCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &(VkExportSemaphoreCreateInfo){
+                .sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
+                .handleTypes = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE
+            },
+        },
+        0, &Semaphore
+    );
+    shared_handle Handle = SharedTexture_ExportSemaphore(Semaphore);
+    VK.Funcs.vkDestroySemaphore(VK.Device, Semaphore, 0);
+    return Handle;
+}
+
+// Publishes the texture as the next generation of Name. Consumers that
+// already hold a previous generation pick it up in SharedTexture_Reopen.
+static bool SharedTexture_Publish(shared_texture *SharedTexture, const char *Name)
+{
+    if (!SharedTexture->Control)
+    {
+        SharedTexture->Control = SharedTexture_MapControl(Name, true, &SHARED_HANDLE(*SharedTexture, ControlHandle));
+        if (!SharedTexture->Control)
+            return false;
+    }
+
+    SharedTexture->Generation = SharedTexture->Control->Generation + 1;
+    char GenerationName[MAX_PATH];
+    SharedTexture_GenerationName(GenerationName, sizeof(GenerationName), Name, SharedTexture->Generation);
+    shared_handle Handles[] = { SHARED_HANDLE(*SharedTexture, MemoryHandle), SHARED_HANDLE(*SharedTexture, SemaphoreHandle) };
+    SharedTexture->Sender = NULL;
+    SharedTexture->Sender = SharedTexture_Send(PIPE_PREFIX, GenerationName, SharedTexture, sizeof(shared_texture), 2, Handles);
+    if (!SharedTexture->Sender)
+        return false;
+
+    // Nothing was written into the new storage yet.
+    SharedTexture_StoreSignal(*SharedTexture, SHARED_TEXTURE_LAYOUT_UNDEFINED, 0);
+    SharedTexture_StoreGeneration(SharedTexture->Control, SharedTexture->Generation);
+    return true;
+}
+
+#if !defined(_WIN32)
+
+// Keeps the requested modifiers the driver can sample from, render to and
+// export as dma-buf for this texture, along with their memory plane counts.
+// Returns the number kept in Modifiers.
+static uint32_t SharedTexture_FilterDrmFormatModifiers(shared_texture SharedTexture, uint32_t ModifierCount, const uint64_t *Requested,
+                                                       uint64_t *Modifiers, uint32_t *PlaneCounts, uint32_t MaxModifiers)
+{
+    VkFormat Format = SharedTexture_ToVulkanFormat(SharedTexture.Format);
+    VkDrmFormatModifierPropertiesListEXT PropertiesList = {
+        .sType = VK_STRUCTURE_TYPE_DRM_FORMAT_MODIFIER_PROPERTIES_LIST_EXT,
+    };
+    VkFormatProperties2 FormatProperties = {
+        .sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2,
+        .pNext = &PropertiesList,
+    };
+    vkGetPhysicalDeviceFormatProperties2(VK.PhysicalDevice, Format, &FormatProperties);
+    VkDrmFormatModifierPropertiesEXT *Properties = calloc(PropertiesList.drmFormatModifierCount, sizeof(VkDrmFormatModifierPropertiesEXT));
+    PropertiesList.pDrmFormatModifierProperties = Properties;
+    vkGetPhysicalDeviceFormatProperties2(VK.PhysicalDevice, Format, &FormatProperties);
+
+    VkImageCreateInfo ImageCreateInfo = SharedTexture_ToVulkanImageCreateInfo(SharedTexture, 0);
+    vk_shared_format_list FormatList;
+    VkFormatFeatureFlags Features = 0;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_SAMPLED) Features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_RENDER) Features |= VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_STORAGE) Features |= VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_TRANSFER_SRC) Features |= VK_FORMAT_FEATURE_TRANSFER_SRC_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_TRANSFER_DST) Features |= VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    uint32_t Count = 0;
+    for (uint32_t i = 0; i < PropertiesList.drmFormatModifierCount && Count < MaxModifiers; ++i)
+    {
+        uint64_t Modifier = Properties[i].drmFormatModifier;
+        if ((Properties[i].drmFormatModifierTilingFeatures & Features) != Features)
+            continue;
+
+        bool Accepted = (Requested == 0);
+        for (uint32_t j = 0; j < ModifierCount && !Accepted; ++j)
+            Accepted = (Requested[j] == Modifier);
+        if (!Accepted)
+            continue;
+
+        VkExternalImageFormatProperties ExternalProperties = {
+            .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+        };
+        VkImageFormatProperties2 ImageFormatProperties = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+            .pNext = &ExternalProperties,
+        };
+        VkResult Result = vkGetPhysicalDeviceImageFormatProperties2(VK.PhysicalDevice,
+            &(VkPhysicalDeviceImageFormatInfo2) {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+                .pNext = &(VkPhysicalDeviceExternalImageFormatInfo) {
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+                    .pNext = &(VkPhysicalDeviceImageDrmFormatModifierInfoEXT) {
+                        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_DRM_FORMAT_MODIFIER_INFO_EXT,
+                        .pNext = SharedTexture_ToVulkanFormatList(SharedTexture, &FormatList, 0),
+                        .drmFormatModifier = Modifier,
+                        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                    },
+                    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+                },
+                .format = ImageCreateInfo.format,
+                .type = ImageCreateInfo.imageType,
+                .tiling = ImageCreateInfo.tiling,
+                .usage = ImageCreateInfo.usage,
+                .flags = ImageCreateInfo.flags,
+            },
+            &ImageFormatProperties
+        );
+        if (Result != VK_SUCCESS ||
+            !(ExternalProperties.externalMemoryProperties.externalMemoryFeatures & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT) ||
+            ImageFormatProperties.imageFormatProperties.maxExtent.width < (uint32_t)SharedTexture.Width ||
+            ImageFormatProperties.imageFormatProperties.maxExtent.height < (uint32_t)SharedTexture.Height)
+            continue;
+
+        Modifiers[Count] = Modifier;
+        PlaneCounts[Count] = Properties[i].drmFormatModifierPlaneCount;
+        ++Count;
+    }
+    free(Properties);
+    return Count;
+}
+
+// Records the modifier the driver picked and where each memory plane lives,
+// importers have to recreate the image with exactly this layout.
+static void SharedTexture_QueryDrmFormatModifierLayout(shared_texture *SharedTexture, VkImage Image,
+                                                       uint32_t ModifierCount, const uint64_t *Modifiers, const uint32_t *PlaneCounts)
+{
+    VkImageDrmFormatModifierPropertiesEXT ModifierProperties = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_PROPERTIES_EXT,
+    };
+    VK.Funcs.vkGetImageDrmFormatModifierPropertiesEXT(VK.Device, Image, &ModifierProperties);
+    SharedTexture->Modifier = ModifierProperties.drmFormatModifier;
+
+    SharedTexture->PlaneCount = 1;
+    for (uint32_t i = 0; i < ModifierCount; ++i)
+        if (Modifiers[i] == SharedTexture->Modifier)
+            SharedTexture->PlaneCount = PlaneCounts[i];
+
+    const VkImageAspectFlagBits PlaneAspects[] = {
+        VK_IMAGE_ASPECT_MEMORY_PLANE_0_BIT_EXT, VK_IMAGE_ASPECT_MEMORY_PLANE_1_BIT_EXT,
+        VK_IMAGE_ASPECT_MEMORY_PLANE_2_BIT_EXT, VK_IMAGE_ASPECT_MEMORY_PLANE_3_BIT_EXT,
+    };
+    for (uint32_t i = 0; i < SharedTexture->PlaneCount && i < 4; ++i)
+    {
+        VkSubresourceLayout Layout;
+        VK.Funcs.vkGetImageSubresourceLayout(VK.Device, Image,
+            &(VkImageSubresource) { .aspectMask = PlaneAspects[i] }, &Layout);
+        SharedTexture->Planes[i].Offset = Layout.offset;
+        SharedTexture->Planes[i].RowPitch = Layout.rowPitch;
+    }
+}
+
+#endif
+
+// Rows are padded to cache lines so row-wise copies never share one.
+static bool SharedTexture_AllocateCpu(shared_texture *SharedTexture)
+{
+    SharedTexture->PlaneCount = 1;
+    SharedTexture->Planes[0].Offset = 0;
+    SharedTexture->Planes[0].RowPitch = ((uint64_t)SharedTexture->Width * SharedTexture_CpuTexelSize(SharedTexture->Format) + 63) & ~63ull;
+    SharedTexture->Size = SharedTexture->Planes[0].RowPitch * SharedTexture->Height;
+    SharedTexture->Flags &= ~SHARED_TEXTURE_FLAG_HUGE_PAGES;
+    SHARED_HANDLE(*SharedTexture, MemoryHandle) = SharedTexture_CreateCpuMemory(SharedTexture);
+    if (SHARED_HANDLE(*SharedTexture, MemoryHandle) == SHARED_HANDLE_NONE)
+        return false;
+    SHARED_HANDLE(*SharedTexture, SemaphoreHandle) = SharedTexture_CreateCpuSemaphore();
+    return true;
+}
+
+// Linear tiling supports far fewer formats and usages than optimal, so it is
+// asked for before the image is created.
+static bool SharedTexture_SupportsLinearTiling(shared_texture SharedTexture)
+{
+    vk_shared_format_list FormatList;
+    VkImageCreateInfo ImageCreateInfo = SharedTexture_ToVulkanImageCreateInfo(SharedTexture, 0);
+    VkExternalImageFormatProperties ExternalProperties = {
+        .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+    };
+    VkImageFormatProperties2 ImageFormatProperties = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+        .pNext = &ExternalProperties,
+    };
+    VkResult Result = vkGetPhysicalDeviceImageFormatProperties2(VK.PhysicalDevice,
+        &(VkPhysicalDeviceImageFormatInfo2) {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+            .pNext = &(VkPhysicalDeviceExternalImageFormatInfo) {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+                .pNext = SharedTexture_ToVulkanFormatList(SharedTexture, &FormatList, 0),
+                .handleType = SharedTexture_ToVulkanHandleType(SharedTexture),
+            },
+            .format = ImageCreateInfo.format,
+            .type = ImageCreateInfo.imageType,
+            .tiling = ImageCreateInfo.tiling,
+            .usage = ImageCreateInfo.usage,
+            .flags = ImageCreateInfo.flags,
+        },
+        &ImageFormatProperties
+    );
+    return Result == VK_SUCCESS &&
+        (ExternalProperties.externalMemoryProperties.externalMemoryFeatures & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT) &&
+        ImageFormatProperties.imageFormatProperties.maxExtent.width >= (uint32_t)SharedTexture.Width &&
+        ImageFormatProperties.imageFormatProperties.maxExtent.height >= (uint32_t)SharedTexture.Height;
+}
+
+static bool SharedTexture_Allocate(shared_texture *SharedTexture, uint32_t ModifierCount, const uint64_t *Modifiers)
+{
+    if (SharedTexture->Flags & SHARED_TEXTURE_FLAG_CPU)
+        return SharedTexture_AllocateCpu(SharedTexture);
+    bool Linear = (SharedTexture->Flags & SHARED_TEXTURE_FLAG_HOST) || SHARED_TEXTURE_IS_YCBCR(SharedTexture->Format);
+    if (Linear && !(SharedTexture->Flags & SHARED_TEXTURE_FLAG_DMA_BUF) && !SharedTexture_SupportsLinearTiling(*SharedTexture))
+        return false;
+
+    // IMAGE
+    VkImage Image = VK_NULL_HANDLE;
+#if !defined(_WIN32)
+    if (SharedTexture->Flags & SHARED_TEXTURE_FLAG_DMA_BUF)
+    {
+        // Consumers outside this library only read what Modifier and Planes say,
+        // so the modifier is settled here and published with the descriptor.
+        uint64_t Supported[64];
+        uint32_t PlaneCounts[64];
+        uint32_t SupportedCount = SharedTexture_FilterDrmFormatModifiers(*SharedTexture, ModifierCount, Modifiers, Supported, PlaneCounts, 64);
+        if (SupportedCount == 0)
+            return false;
+        Image = SharedTexture_CreateVulkanImage(*SharedTexture, SupportedCount, Supported);
+        if (Image == VK_NULL_HANDLE)
+            return false;
+        SharedTexture_QueryDrmFormatModifierLayout(SharedTexture, Image, SupportedCount, Supported, PlaneCounts);
+    }
+    else
+#endif
+    Image = SharedTexture_CreateVulkanImage(*SharedTexture, 0, 0);
+    if (Image == VK_NULL_HANDLE)
+        return false;
+
+    // The resolve ring follows the multisampled image in the same memory, so
+    // one handle and one semaphore cover both.
+    VkImage Resolve = VK_NULL_HANDLE;
+    if (SharedTexture->ResolveSlots)
+    {
+        Resolve = SharedTexture_CreateVulkanImage(SharedTexture_ToResolve(*SharedTexture), 0, 0);
+        if (Resolve == VK_NULL_HANDLE)
+        {
+            VK.Funcs.vkDestroyImage(VK.Device, Image, 0);
+            return false;
+        }
+    }
+
+    // MEMORY
+    // Drivers may only keep framebuffer compression on external images with
+    // dedicated allocations, so use one whenever it is preferred.
+    bool Dedicated;
+    VkMemoryRequirements MemReqs = SharedTexture_GetVulkanMemoryRequirements(Image, VK.Device, &Dedicated, 0);
+    if (Resolve)
+    {
+        VkMemoryRequirements ResolveMemReqs = SharedTexture_GetVulkanMemoryRequirements(Resolve, VK.Device, 0, 0);
+        SharedTexture->ResolveOffset = (MemReqs.size + ResolveMemReqs.alignment - 1) & ~(ResolveMemReqs.alignment - 1);
+        MemReqs.size = SharedTexture->ResolveOffset + ResolveMemReqs.size;
+        MemReqs.memoryTypeBits &= ResolveMemReqs.memoryTypeBits;
+        Dedicated = false;
+    }
+    uint32_t MemoryTypeIndex = SharedTexture_FindVulkanMemoryType(*SharedTexture, MemReqs.memoryTypeBits, VK.PhysicalDevice);
+    VkExternalMemoryHandleTypeFlagBits HandleType = SharedTexture_ToVulkanHandleType(*SharedTexture);
+    VkDeviceMemory Memory = VK_NULL_HANDLE;
+    if (MemoryTypeIndex != UINT32_MAX)
+        Memory = SharedTexture_AllocateExportableMemory(MemReqs.size, MemoryTypeIndex, Dedicated ? Image : VK_NULL_HANDLE, HandleType);
+    if (Memory == VK_NULL_HANDLE)
+    {
+        if (Resolve)
+            VK.Funcs.vkDestroyImage(VK.Device, Resolve, 0);
+        VK.Funcs.vkDestroyImage(VK.Device, Image, 0);
+        return false;
+    }
+
+    if (Dedicated)
+        SharedTexture->Flags |= SHARED_TEXTURE_FLAG_DEDICATED;
+    else
+        SharedTexture->Flags &= ~SHARED_TEXTURE_FLAG_DEDICATED;
+
+    SharedTexture->Size = MemReqs.size;
+    SHARED_HANDLE(*SharedTexture, MemoryHandle) = SharedTexture_ExportMemory(Memory, HandleType);
+
+    // Linear layouts are published so nobody has to guess plane placement or pitch.
+    bool YCbCr = SHARED_TEXTURE_IS_YCBCR(SharedTexture->Format);
+    if ((SharedTexture->Flags & SHARED_TEXTURE_FLAG_HOST) || YCbCr)
+    {
+        const VkImageAspectFlagBits PlaneAspects[] = {
+            VK_IMAGE_ASPECT_PLANE_0_BIT, VK_IMAGE_ASPECT_PLANE_1_BIT, VK_IMAGE_ASPECT_PLANE_2_BIT,
+        };
+        SharedTexture->PlaneCount = YCbCr ? (SharedTexture->Format == SHARED_TEXTURE_I420 ? 3 : 2) : 1;
+        for (uint32_t i = 0; i < SharedTexture->PlaneCount; ++i)
+        {
+            VkSubresourceLayout Layout;
+            VK.Funcs.vkGetImageSubresourceLayout(VK.Device, Image,
+                &(VkImageSubresource) { .aspectMask = YCbCr ? PlaneAspects[i] : VK_IMAGE_ASPECT_COLOR_BIT }, &Layout);
+            SharedTexture->Planes[i].Offset = Layout.offset;
+            SharedTexture->Planes[i].RowPitch = Layout.rowPitch;
+        }
+    }
+
+    // SEMAPHORE
+    SHARED_HANDLE(*SharedTexture, SemaphoreHandle) = SharedTexture_CreateSemaphore();
+
+    VK.Funcs.vkFreeMemory(VK.Device, Memory, 0);
+    if (Resolve)
+        VK.Funcs.vkDestroyImage(VK.Device, Resolve, 0);
+    VK.Funcs.vkDestroyImage(VK.Device, Image, 0);
+    return true;
+}
+
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_CreateEx(const char *Name, const shared_texture_create_info *CreateInfo)
+{
+    shared_texture SharedTexture = SharedTexture_FromCreateInfo(CreateInfo);
+    if (SharedTexture.Format == SHARED_TEXTURE_NONE)
+        return SharedTexture;
+
+    if (!SharedTexture_Allocate(&SharedTexture, CreateInfo->ModifierCount, CreateInfo->Modifiers))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    if (SharedTexture_Publish(&SharedTexture, Name))
+        return SharedTexture;
+
+    SharedTexture_Close(SharedTexture);
+    return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+}
+
+// Replaces the storage of SharedTexture with that described by Next.
+static bool SharedTexture_Reallocate(shared_texture *SharedTexture, const char *Name, shared_texture Next)
+{
+    if (SharedTexture->Flags & SHARED_TEXTURE_FLAG_HEAP)
+        return false;
+
+    // Stay on the modifier consumers already accepted.
+    if (!SharedTexture_Allocate(&Next, 1, &SharedTexture->Modifier))
+        return false;
+    if (!SharedTexture_Publish(&Next, Name))
+    {
+        SharedTexture_CloseHandles(Next);
+        return false;
+    }
+
+    // Consumers still rendering from the previous generation hold their own
+    // duplicated handles and imports, which keep the old storage alive until
+    // they re-import. Closing waits only for those still being sent it.
+    SharedTexture_CloseHandles(*SharedTexture);
+    *SharedTexture = Next;
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_Resize(shared_texture *SharedTexture, const char *Name, int32_t Width, int32_t Height)
+{
+    shared_texture Next = *SharedTexture;
+    Next.Width = Width;
+    Next.Height = Height;
+    if (Next.Type == SHARED_TEXTURE_CUBE && Width != Height)
+        return false;
+
+    // Pick up usage requested since the last generation on the way.
+    if (SharedTexture->Control)
+        Next.Usage |= (uint32_t)SharedTexture->Control->Usage;
+    return SharedTexture_Reallocate(SharedTexture, Name, Next);
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_RequestUsage(shared_texture *SharedTexture, uint32_t Usage)
+{
+    if ((SharedTexture->Usage & Usage) == Usage)
+        return true;
+    if (SharedTexture->Control)
+        SharedTexture_AddUsage(SharedTexture->Control, Usage);
+    return false;
+}
+
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_ToResolve(shared_texture SharedTexture)
+{
+    shared_texture Resolve = SharedTexture;
+    Resolve.Type = SHARED_TEXTURE_2D_ARRAY;
+    Resolve.Layers = SharedTexture.ResolveSlots;
+    Resolve.Flags &= ~SHARED_TEXTURE_FLAG_DEDICATED;
+    Resolve.Offset = SharedTexture.ResolveOffset;
+    Resolve.Usage = SHARED_TEXTURE_USAGE_SAMPLED | SHARED_TEXTURE_USAGE_TRANSFER_SRC | SHARED_TEXTURE_USAGE_TRANSFER_DST;
+    Resolve.Samples = 1;
+    Resolve.ResolveSlots = 0;
+    Resolve.ResolveOffset = 0;
+    return Resolve;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_NeedsColorConversion(shared_texture SharedTexture, uint32_t Primaries, uint32_t Transfer)
+{
+    uint32_t SampledTransfer = SharedTexture.Transfer;
+    if (SharedTexture.Format == SHARED_TEXTURE_RGBA8_SRGB)
+        SampledTransfer = SHARED_TEXTURE_TRANSFER_LINEAR;
+    return SharedTexture.Primaries != Primaries || SampledTransfer != Transfer;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_UpdateUsage(shared_texture *SharedTexture, const char *Name)
+{
+    if (!SharedTexture->Control)
+        return false;
+
+    uint32_t Usage = SharedTexture->Usage | (uint32_t)SharedTexture->Control->Usage;
+    if (Usage == SharedTexture->Usage)
+        return false;
+
+    shared_texture Next = *SharedTexture;
+    Next.Usage = Usage;
+    return SharedTexture_Reallocate(SharedTexture, Name, Next);
+}
+
+//
+// HOST
+//
+
+typedef struct shared_texture_host
+{
+    vk_shared_texture Texture;
+    VkFence Fence;
+    bool Coherent;
+    shared_texture_control *Control;    // borrowed from the texture
+    // SharedTexture_Map only, on the library queue
+    VkImageAspectFlags Aspect;
+    VkCommandBuffer Acquire;        // into GENERAL for host access, recorded per wait
+    VkCommandBuffer Release;        // back to the other processes in GENERAL
+    // SHARED_TEXTURE_FLAG_CPU only, Semaphore is borrowed from the texture
+    uint8_t *Cpu;
+    uint64_t Size;
+    uint64_t RowPitch;
+    shared_handle Semaphore;
+    // SharedTexture_CreateFromHostPointer only
+    const uint8_t *Source;
+    uint64_t SourcePitch;
+    uint64_t RowSize;
+    int32_t Height;
+    VkBuffer Buffer;                // Source imported, or a staging copy of it
+    VkDeviceMemory BufferMemory;
+    uint8_t *Staging;               // without VK_EXT_external_memory_host
+    VkQueue Queue;                  // see SharedTexture_CopyQueue
+    VkCommandPool CommandPool;
+    VkCommandBuffer CommandBuffer;  // the upload, recorded once
+    bool Pending;                   // upload or release submitted and Fence not waited on
+    bool Published;
+} shared_texture_host;
+
+static bool SharedTexture_MapCpu(shared_texture SharedTexture, shared_texture_mapping *Mapping)
+{
+    uint8_t *Data = SharedTexture_MapCpuMemory(SharedTexture);
+    if (!Data || !SharedTexture.Control)
+    {
+        if (Data)
+            SharedTexture_UnmapCpuMemory(Data, SharedTexture.Size);
+        return false;
+    }
+
+    shared_texture_host *Host = calloc(1, sizeof(shared_texture_host));
+    if (!Host)
+    {
+        SharedTexture_UnmapCpuMemory(Data, SharedTexture.Size);
+        return false;
+    }
+    Host->Cpu = Data;
+    Host->Size = SharedTexture.Size;
+    Host->RowPitch = SharedTexture.Planes[0].RowPitch;
+    Host->Control = SharedTexture.Control;
+    Host->Semaphore = SHARED_HANDLE(SharedTexture, SemaphoreHandle);
+
+    Mapping->Data = Data + SharedTexture.Planes[0].Offset;
+    Mapping->RowPitch = SharedTexture.Planes[0].RowPitch;
+    Mapping->Internal = Host;
+    return true;
+}
+
+// Host access to a linear image is only defined in VK_IMAGE_LAYOUT_GENERAL, so
+// every wait takes the image over into it and every signal hands it back in it.
+static void SharedTexture_RecordHostBarrier(shared_texture_host *Host, VkCommandBuffer CommandBuffer, VkImageLayout OldLayout, bool Acquire)
+{
+    VK.Funcs.vkBeginCommandBuffer(CommandBuffer, &(VkCommandBufferBeginInfo) { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO });
+    VkImageMemoryBarrier Barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = Acquire ? 0 : VK_ACCESS_HOST_WRITE_BIT,
+        .dstAccessMask = Acquire ? VK_ACCESS_HOST_READ_BIT | VK_ACCESS_HOST_WRITE_BIT : 0,
+        .oldLayout = OldLayout,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = Acquire ? VK_QUEUE_FAMILY_EXTERNAL : VK.QueueFamilyIndex,
+        .dstQueueFamilyIndex = Acquire ? VK.QueueFamilyIndex : VK_QUEUE_FAMILY_EXTERNAL,
+        .image = Host->Texture.Image,
+        .subresourceRange = { Host->Aspect, 0, 1, 0, 1 },
+    };
+    VK.Funcs.vkCmdPipelineBarrier(CommandBuffer,
+        Acquire ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_HOST_BIT,
+        Acquire ? VK_PIPELINE_STAGE_HOST_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, 0, 0, 0, 1, &Barrier);
+    VK.Funcs.vkEndCommandBuffer(CommandBuffer);
+}
+
+static bool SharedTexture_CreateHostAccess(shared_texture_host *Host)
+{
+    VkResult Result = VK.Funcs.vkCreateCommandPool(VK.Device,
+        &(VkCommandPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = VK.QueueFamilyIndex,
+        },
+        0, &Host->CommandPool
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    VkCommandBuffer CommandBuffers[2];
+    Result = VK.Funcs.vkAllocateCommandBuffers(VK.Device,
+        &(VkCommandBufferAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = Host->CommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 2,
+        },
+        CommandBuffers
+    );
+    if (Result != VK_SUCCESS ||
+        VK.Funcs.vkCreateFence(VK.Device, &(VkFenceCreateInfo) { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO }, 0, &Host->Fence) != VK_SUCCESS)
+        return false;
+    Host->Acquire = CommandBuffers[0];
+    Host->Release = CommandBuffers[1];
+    SharedTexture_RecordHostBarrier(Host, Host->Release, VK_IMAGE_LAYOUT_GENERAL, false);
+    return true;
+}
+
+static bool SharedTexture_FinishHostUpload(shared_texture_host *Host);
+
+static void SharedTexture_DestroyHostAccess(shared_texture_host *Host)
+{
+    SharedTexture_FinishHostUpload(Host);
+    if (Host->Fence)
+        VK.Funcs.vkDestroyFence(VK.Device, Host->Fence, 0);
+    if (Host->CommandPool)
+        VK.Funcs.vkDestroyCommandPool(VK.Device, Host->CommandPool, 0);
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_Map(shared_texture SharedTexture, shared_texture_mapping *Mapping)
+{
+    *Mapping = (shared_texture_mapping) { 0 };
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_CPU)
+        return SharedTexture_MapCpu(SharedTexture, Mapping);
+    if (!(SharedTexture.Flags & SHARED_TEXTURE_FLAG_HOST) || !SharedTexture_RequireDevice() || VK.Queue == VK_NULL_HANDLE)
+        return false;
+
+    shared_texture_host *Host = calloc(1, sizeof(shared_texture_host));
+    if (!Host)
+        return false;
+    Host->Texture = SharedTexture_ToVulkan(SharedTexture, VK.Device, VK.PhysicalDevice);
+
+    uint32_t MemoryTypeIndex = UINT32_MAX;
+    if (Host->Texture.Image != VK_NULL_HANDLE)
+    {
+        VkMemoryRequirements MemReqs;
+        VK.Funcs.vkGetImageMemoryRequirements(VK.Device, Host->Texture.Image, &MemReqs);
+        MemoryTypeIndex = SharedTexture_FindVulkanMemoryType(SharedTexture, MemReqs.memoryTypeBits, VK.PhysicalDevice);
+    }
+    if (MemoryTypeIndex != UINT32_MAX)
+    {
+        VkPhysicalDeviceMemoryProperties MemoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(VK.PhysicalDevice, &MemoryProperties);
+        Host->Coherent = MemoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+
+    void *Data = 0;
+    if (MemoryTypeIndex == UINT32_MAX || Host->Texture.Memory == VK_NULL_HANDLE ||
+        VK.Funcs.vkMapMemory(VK.Device, Host->Texture.Memory, 0, VK_WHOLE_SIZE, 0, &Data) != VK_SUCCESS)
+    {
+        SharedTexture_DestroyVulkanTexture(Host->Texture, VK.Device);
+        free(Host);
+        return false;
+    }
+    Host->Control = SharedTexture.Control;
+    Host->Aspect = SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    if (!SharedTexture_CreateHostAccess(Host))
+    {
+        SharedTexture_DestroyHostAccess(Host);
+        VK.Funcs.vkUnmapMemory(VK.Device, Host->Texture.Memory);
+        SharedTexture_DestroyVulkanTexture(Host->Texture, VK.Device);
+        free(Host);
+        return false;
+    }
+
+    Mapping->Data = (uint8_t *)Data + SharedTexture.Planes[0].Offset;
+    Mapping->RowPitch = SharedTexture.Planes[0].RowPitch;
+    Mapping->Internal = Host;
+    return true;
+}
+
+// Memory imported from a host pointer cannot be exported again, so the
+// caller's frame stays in its process and the GPU copies it into the shared
+// image straight from those pages. Without VK_EXT_external_memory_host, or if
+// pointer or size are not aligned for it, the frame goes through a staging
+// buffer. Rounding the size up would import memory past the caller's frame.
+static bool SharedTexture_ImportHostPointer(shared_texture_host *Host, uint64_t Size)
+{
+    if (!VK.HostPointer || ((uintptr_t)Host->Source & (VK.HostPointerAlignment - 1)) || (Size & (VK.HostPointerAlignment - 1)))
+        return false;
+
+    VkResult Result = VK.Funcs.vkCreateBuffer(VK.Device,
+        &(VkBufferCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .pNext = &(VkExternalMemoryBufferCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+                .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+            },
+            .size = Size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        },
+        0, &Host->Buffer
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements MemReqs;
+    VK.Funcs.vkGetBufferMemoryRequirements(VK.Device, Host->Buffer, &MemReqs);
+    VkMemoryHostPointerPropertiesEXT HostPointerProperties = { .sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT };
+    Result = VK.Funcs.vkGetMemoryHostPointerPropertiesEXT(VK.Device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+                                                 Host->Source, &HostPointerProperties);
+    int32_t MemoryTypeIndex = Vulkan_FindPhysicalDeviceMemoryIndex(VK.PhysicalDevice,
+        MemReqs.memoryTypeBits & HostPointerProperties.memoryTypeBits, (VkMemoryPropertyFlagBits)0);
+    if (Result == VK_SUCCESS && MemoryTypeIndex >= 0 && MemReqs.size <= Size)
+        Result = VK.Funcs.vkAllocateMemory(VK.Device,
+            &(VkMemoryAllocateInfo) {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .pNext = &(VkImportMemoryHostPointerInfoEXT) {
+                    .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+                    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+                    .pHostPointer = (void *)Host->Source,
+                },
+                .allocationSize = Size,
+                .memoryTypeIndex = (uint32_t)MemoryTypeIndex,
+            },
+            0, &Host->BufferMemory
+        );
+    if (Result != VK_SUCCESS || MemoryTypeIndex < 0 || MemReqs.size > Size ||
+        VK.Funcs.vkBindBufferMemory(VK.Device, Host->Buffer, Host->BufferMemory, 0) != VK_SUCCESS)
+    {
+        if (Host->BufferMemory)
+            VK.Funcs.vkFreeMemory(VK.Device, Host->BufferMemory, 0);
+        VK.Funcs.vkDestroyBuffer(VK.Device, Host->Buffer, 0);
+        Host->Buffer = VK_NULL_HANDLE;
+        Host->BufferMemory = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+static bool SharedTexture_CreateStaging(shared_texture_host *Host, shared_texture SharedTexture, uint64_t Size)
+{
+    VkResult Result = VK.Funcs.vkCreateBuffer(VK.Device,
+        &(VkBufferCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = Size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        },
+        0, &Host->Buffer
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements MemReqs;
+    VK.Funcs.vkGetBufferMemoryRequirements(VK.Device, Host->Buffer, &MemReqs);
+    shared_texture Staging = SharedTexture;
+    Staging.Flags |= SHARED_TEXTURE_FLAG_HOST;
+    uint32_t MemoryTypeIndex = SharedTexture_FindVulkanMemoryType(Staging, MemReqs.memoryTypeBits, VK.PhysicalDevice);
+    if (MemoryTypeIndex == UINT32_MAX)
+        return false;
+    VkPhysicalDeviceMemoryProperties MemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(VK.PhysicalDevice, &MemoryProperties);
+    Host->Coherent = (MemoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+    Result = VK.Funcs.vkAllocateMemory(VK.Device,
+        &(VkMemoryAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = MemReqs.size,
+            .memoryTypeIndex = MemoryTypeIndex,
+        },
+        0, &Host->BufferMemory
+    );
+    return Result == VK_SUCCESS &&
+           VK.Funcs.vkBindBufferMemory(VK.Device, Host->Buffer, Host->BufferMemory, 0) == VK_SUCCESS &&
+           VK.Funcs.vkMapMemory(VK.Device, Host->BufferMemory, 0, VK_WHOLE_SIZE, 0, (void **)&Host->Staging) == VK_SUCCESS;
+}
+
+// The upload is the same every frame, so it is recorded once. The frame
+// replaces the whole image and its old contents are discarded.
+static bool SharedTexture_CreateHostUpload(shared_texture_host *Host, shared_texture SharedTexture)
+{
+    uint64_t Size = Host->SourcePitch * (uint64_t)(Host->Height - 1) + Host->RowSize;
+    uint32_t QueueFamilyIndex;
+    Host->Queue = SharedTexture_CopyQueue(&QueueFamilyIndex);
+    Host->Control = SharedTexture.Control;
+    if (Host->Queue == VK_NULL_HANDLE)
+        return false;
+    Host->Texture = SharedTexture_ToVulkan(SharedTexture, VK.Device, VK.PhysicalDevice);
+    if (Host->Texture.Image == VK_NULL_HANDLE ||
+        (!SharedTexture_ImportHostPointer(Host, Size) && !SharedTexture_CreateStaging(Host, SharedTexture, Size)))
+        return false;
+
+    VkResult Result = VK.Funcs.vkCreateCommandPool(VK.Device,
+        &(VkCommandPoolCreateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .queueFamilyIndex = QueueFamilyIndex,
+        },
+        0, &Host->CommandPool
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    Result = VK.Funcs.vkAllocateCommandBuffers(VK.Device,
+        &(VkCommandBufferAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = Host->CommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        },
+        &Host->CommandBuffer
+    );
+    if (Result != VK_SUCCESS ||
+        VK.Funcs.vkCreateFence(VK.Device, &(VkFenceCreateInfo) { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO }, 0, &Host->Fence) != VK_SUCCESS)
+        return false;
+
+    VkImageAspectFlags Aspect = SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    VkCommandBuffer CommandBuffer = Host->CommandBuffer;
+    VK.Funcs.vkBeginCommandBuffer(CommandBuffer, &(VkCommandBufferBeginInfo) { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO });
+    VkImageMemoryBarrier Barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = Host->Texture.Image,
+        .subresourceRange = { Aspect, 0, 1, 0, 1 },
+    };
+    VK.Funcs.vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &Barrier);
+    VK.Funcs.vkCmdCopyBufferToImage(CommandBuffer, Host->Buffer, Host->Texture.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+        &(VkBufferImageCopy) {
+            .bufferRowLength = (uint32_t)(Host->SourcePitch / SharedTexture_CpuTexelSize(SharedTexture.Format)),
+            .imageSubresource = { Aspect, 0, 0, 1 },
+            .imageExtent = { SharedTexture.Width, SharedTexture.Height, 1 },
+        }
+    );
+    Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barrier.dstAccessMask = 0;
+    Barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    Barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    Barrier.srcQueueFamilyIndex = QueueFamilyIndex;
+    Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    VK.Funcs.vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, 1, &Barrier);
+    return VK.Funcs.vkEndCommandBuffer(CommandBuffer) == VK_SUCCESS;
+}
+
+static bool SharedTexture_FinishHostUpload(shared_texture_host *Host)
+{
+    if (!Host->Pending)
+        return true;
+    if (VK.Funcs.vkWaitForFences(VK.Device, 1, &Host->Fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+        return false;
+    VK.Funcs.vkResetFences(VK.Device, 1, &Host->Fence);
+    Host->Pending = false;
+    return true;
+}
+
+static bool SharedTexture_HostUpload(shared_texture_host *Host)
+{
+    // Without a device the frame is copied once the consumers handed the texture back.
+    if (Host->Cpu)
+    {
+        if (Host->Published)
+            SharedTexture_CpuWait(Host->Control, Host->Semaphore);
+        SharedTexture_HostCopy(Host->Cpu, Host->RowPitch, Host->Source, Host->SourcePitch, Host->RowSize, Host->Height);
+        SharedTexture_CpuSignal(Host->Control, Host->Semaphore);
+        Host->Published = true;
+        return true;
+    }
+
+    // The command buffer and the staging buffer are reused.
+    if (!SharedTexture_FinishHostUpload(Host))
+        return false;
+    if (Host->Staging)
+    {
+        SharedTexture_HostCopy(Host->Staging, Host->SourcePitch, Host->Source, Host->SourcePitch, Host->RowSize, Host->Height);
+        if (!Host->Coherent)
+            VK.Funcs.vkFlushMappedMemoryRanges(VK.Device, 1,
+                &(VkMappedMemoryRange) {
+                    .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                    .memory = Host->BufferMemory,
+                    .size = VK_WHOLE_SIZE,
+                }
+            );
+    }
+
+    VkResult Result = VK.Funcs.vkQueueSubmit(Host->Queue, 1,
+        &(VkSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            // Consumers hand the texture back by signalling, nobody has before the first frame.
+            .waitSemaphoreCount = Host->Published ? 1 : 0,
+            .pWaitSemaphores = &Host->Texture.Semaphore,
+            .pWaitDstStageMask = (VkPipelineStageFlags[]){ VK_PIPELINE_STAGE_TRANSFER_BIT },
+            .commandBufferCount = 1,
+            .pCommandBuffers = &Host->CommandBuffer,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &Host->Texture.Semaphore,
+        },
+        Host->Fence
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    SharedTexture_StoreLayout((shared_texture) { .Control = Host->Control }, SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY);
+    Host->Pending = true;
+    Host->Published = true;
+    return true;
+}
+
+// Source may be written again once this returns, a staging copy released it already.
+static bool SharedTexture_HostUploadWait(shared_texture_host *Host)
+{
+    return Host->Staging || SharedTexture_FinishHostUpload(Host);
+}
+
+static void SharedTexture_DestroyHostUpload(shared_texture_host *Host)
+{
+    if (Host->Cpu)
+    {
+        SharedTexture_UnmapCpuMemory(Host->Cpu, Host->Size);
+        free(Host);
+        return;
+    }
+
+    SharedTexture_FinishHostUpload(Host);
+    if (Host->Fence)
+        VK.Funcs.vkDestroyFence(VK.Device, Host->Fence, 0);
+    if (Host->CommandPool)
+        VK.Funcs.vkDestroyCommandPool(VK.Device, Host->CommandPool, 0);
+    if (Host->Buffer)
+        VK.Funcs.vkDestroyBuffer(VK.Device, Host->Buffer, 0);
+    if (Host->BufferMemory)
+        VK.Funcs.vkFreeMemory(VK.Device, Host->BufferMemory, 0);
+    SharedTexture_DestroyVulkanTexture(Host->Texture, VK.Device);
+    free(Host);
+}
+
+void SHARED_TEXTURE_EXPORT SharedTexture_Unmap(shared_texture_mapping *Mapping)
+{
+    shared_texture_host *Host = Mapping->Internal;
+    if (!Host) return;
+
+    if (Host->Source)
+    {
+        SharedTexture_DestroyHostUpload(Host);
+        *Mapping = (shared_texture_mapping) { 0 };
+        return;
+    }
+
+    if (Host->Cpu)
+    {
+        SharedTexture_UnmapCpuMemory(Host->Cpu, Host->Size);
+        free(Host);
+        *Mapping = (shared_texture_mapping) { 0 };
+        return;
+    }
+
+    SharedTexture_DestroyHostAccess(Host);
+    VK.Funcs.vkUnmapMemory(VK.Device, Host->Texture.Memory);
+    SharedTexture_DestroyVulkanTexture(Host->Texture, VK.Device);
+    free(Host);
+    *Mapping = (shared_texture_mapping) { 0 };
+}
+
+// Waits on the shared semaphore through a submit on the library queue that
+// takes the image over in GENERAL.
+bool SHARED_TEXTURE_EXPORT SharedTexture_HostWait(shared_texture_mapping *Mapping)
+{
+    shared_texture_host *Host = Mapping->Internal;
+    if (Host->Source)
+        return SharedTexture_HostUploadWait(Host);
+    if (Host->Cpu)
+    {
+        SharedTexture_CpuWait(Host->Control, Host->Semaphore);
+        return true;
+    }
+
+    if (!SharedTexture_FinishHostUpload(Host))
+        return false;
+    SharedTexture_RecordHostBarrier(Host, Host->Acquire,
+        SharedTexture_ToVulkanLayout(SharedTexture_SignalLayout((shared_texture) { .Control = Host->Control })), true);
+    VkResult Result = VK.Funcs.vkQueueSubmit(VK.Queue, 1,
+        &(VkSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &Host->Texture.Semaphore,
+            .pWaitDstStageMask = (VkPipelineStageFlags[]) { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT },
+            .commandBufferCount = 1,
+            .pCommandBuffers = &Host->Acquire,
+        },
+        Host->Fence
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    Host->Pending = true;
+    if (!SharedTexture_FinishHostUpload(Host))
+        return false;
+
+    if (!Host->Coherent)
+        VK.Funcs.vkInvalidateMappedMemoryRanges(VK.Device, 1,
+            &(VkMappedMemoryRange) {
+                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .memory = Host->Texture.Memory,
+                .size = VK_WHOLE_SIZE,
+            }
+        );
+    return true;
+}
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_HostSignal(shared_texture_mapping *Mapping)
+{
+    shared_texture_host *Host = Mapping->Internal;
+    if (Host->Source)
+        return SharedTexture_HostUpload(Host);
+    if (Host->Cpu)
+    {
+        SharedTexture_CpuSignal(Host->Control, Host->Semaphore);
+        return true;
+    }
+
+    if (!Host->Coherent)
+        VK.Funcs.vkFlushMappedMemoryRanges(VK.Device, 1,
+            &(VkMappedMemoryRange) {
+                .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+                .memory = Host->Texture.Memory,
+                .size = VK_WHOLE_SIZE,
+            }
+        );
+
+    // Release is recorded once, its previous submit has to be done first.
+    if (!SharedTexture_FinishHostUpload(Host))
+        return false;
+    VkResult Result = VK.Funcs.vkQueueSubmit(VK.Queue, 1,
+        &(VkSubmitInfo) {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &Host->Release,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &Host->Texture.Semaphore,
+        },
+        Host->Fence
+    );
+    if (Result != VK_SUCCESS)
+        return false;
+    SharedTexture_StoreLayout((shared_texture) { .Control = Host->Control }, SHARED_TEXTURE_LAYOUT_GENERAL);
+    Host->Pending = true;
+    return true;
+}
+
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_CreateFromHostPointer(const char *Name, const shared_texture_create_info *CreateInfo,
+                                                                        const void *Pointer, uint64_t RowPitch, shared_texture_mapping *Mapping)
+{
+    *Mapping = (shared_texture_mapping) { 0 };
+    uint64_t RowSize = (uint64_t)CreateInfo->Width * SharedTexture_CpuTexelSize(CreateInfo->Format);
+    if (!Pointer || !RowSize || CreateInfo->Type != SHARED_TEXTURE_2D || CreateInfo->Height <= 0 || CreateInfo->Samples > 1 ||
+        (CreateInfo->Flags & ~SHARED_TEXTURE_FLAG_CPU) || RowPitch < RowSize || RowPitch % (RowSize / CreateInfo->Width))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    shared_texture_create_info UploadCreateInfo = *CreateInfo;
+    UploadCreateInfo.Usage = (CreateInfo->Usage ? CreateInfo->Usage : SHARED_TEXTURE_USAGE_DEFAULT) | SHARED_TEXTURE_USAGE_TRANSFER_DST;
+    shared_texture SharedTexture = SharedTexture_CreateEx(Name, &UploadCreateInfo);
+    if (SharedTexture.Format == SHARED_TEXTURE_NONE)
+        return SharedTexture;
+
+    shared_texture_host *Host = 0;
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_CPU)
+    {
+        if (SharedTexture_MapCpu(SharedTexture, Mapping))
+            Host = Mapping->Internal;
+    }
+    else
+        Host = calloc(1, sizeof(shared_texture_host));
+    if (Host)
+    {
+        Host->Source = Pointer;
+        Host->SourcePitch = RowPitch;
+        Host->RowSize = RowSize;
+        Host->Height = SharedTexture.Height;
+    }
+    if (!Host || (!Host->Cpu && !SharedTexture_CreateHostUpload(Host, SharedTexture)))
+    {
+        if (Host)
+            SharedTexture_DestroyHostUpload(Host);
+        *Mapping = (shared_texture_mapping) { 0 };
+        SharedTexture_Close(SharedTexture);
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    }
+
+    Mapping->Data = (uint8_t *)Pointer;
+    Mapping->RowPitch = RowPitch;
+    Mapping->Internal = Host;
+    return SharedTexture;
+}
+
+//
+// HEAP
+//
+
+shared_texture_heap SHARED_TEXTURE_EXPORT SharedTextureHeap_Create(const char *Name, uint64_t Size)
+{
+    if (!SharedTexture_RequireDevice())
+        return (shared_texture_heap) { 0 };
+
+    uint32_t MemoryTypeIndex = SharedTextureHeap_FindVulkanMemoryType(VK.Device, VK.PhysicalDevice);
+    if (MemoryTypeIndex == UINT32_MAX)
+        return (shared_texture_heap) { 0 };
+
+    VkDeviceMemory Memory = SharedTexture_AllocateExportableMemory(Size, MemoryTypeIndex, VK_NULL_HANDLE, VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE);
+    if (Memory == VK_NULL_HANDLE)
+        return (shared_texture_heap) { 0 };
+
+    shared_texture_heap Heap = {
+        .Size = Size,
+        .Used = 0,
+    #if defined(_WIN32)
+        .Win32.MemoryHandle = SharedTexture_ExportMemory(Memory, VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE),
+    #else
+        .Posix.MemoryHandle = SharedTexture_ExportMemory(Memory, VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE),
+    #endif
+    };
+    VK.Funcs.vkFreeMemory(VK.Device, Memory, 0);
+
+    Heap.Sender = SharedTexture_Send(HEAP_PIPE_PREFIX, Name, &Heap, sizeof(shared_texture_heap), 1, &SHARED_HANDLE(Heap, MemoryHandle));
+    if (Heap.Sender)
+        return Heap;
+
+    SharedTextureHeap_Close(Heap);
+    return (shared_texture_heap) { 0 };
+}
+
+shared_texture_heap SHARED_TEXTURE_EXPORT SharedTextureHeap_Open(const char *Name)
+{
+    shared_texture_heap Heap = { 0 };
+    shared_handle *Handles[] = { &SHARED_HANDLE(Heap, MemoryHandle) };
+    if (SharedTexture_Receive(HEAP_PIPE_PREFIX, Name, &Heap, sizeof(shared_texture_heap), 1, Handles))
+    {
+        Heap.Sender = NULL;
+        return Heap;
+    }
+
+    return (shared_texture_heap) { 0 };
+}
+
+void SHARED_TEXTURE_EXPORT SharedTextureHeap_Close(shared_texture_heap Heap)
+{
+    SharedTexture_StopSend(Heap.Sender);
+    SharedTexture_CloseHandle(SHARED_HANDLE(Heap, MemoryHandle));
+}
+
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_CreateInHeap(shared_texture_heap *Heap, const char *Name, const shared_texture_create_info *CreateInfo)
+{
+    shared_texture SharedTexture = SharedTexture_FromCreateInfo(CreateInfo);
+    if (SharedTexture.Format == SHARED_TEXTURE_NONE)
+        return SharedTexture;
+
+    // dma-buf, CPU, HOST, YCbCr and multisampled textures are always their own
+    // allocation, the heap has the memory type of a device local probe image.
+    if ((SharedTexture.Flags & (SHARED_TEXTURE_FLAG_DMA_BUF | SHARED_TEXTURE_FLAG_CPU | SHARED_TEXTURE_FLAG_HOST)) ||
+        SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format) || SharedTexture.Samples > 1)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    VkImage Image = SharedTexture_CreateVulkanImage(SharedTexture, 0, 0);
+    if (Image == VK_NULL_HANDLE)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    bool Required;
+    VkMemoryRequirements MemReqs = SharedTexture_GetVulkanMemoryRequirements(Image, VK.Device, 0, &Required);
+    VK.Funcs.vkDestroyImage(VK.Device, Image, 0);
+
+    // A driver that merely prefers its own allocation still binds at an offset.
+    if (Required)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    // The heap was allocated from the memory type of a probe image, textures
+    // whose requirements exclude that type need their own allocation.
+    uint32_t MemoryTypeIndex = SharedTextureHeap_FindVulkanMemoryType(VK.Device, VK.PhysicalDevice);
+    if (MemoryTypeIndex == UINT32_MAX)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    if (!(MemReqs.memoryTypeBits & (1u << MemoryTypeIndex)))
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+
+    uint64_t Offset = (Heap->Used + MemReqs.alignment - 1) & ~(MemReqs.alignment - 1);
+    if (Offset + MemReqs.size > Heap->Size)
+        return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+    Heap->Used = Offset + MemReqs.size;
+
+    SharedTexture.Size = MemReqs.size;
+    SharedTexture.Offset = Offset;
+    SharedTexture.Flags |= SHARED_TEXTURE_FLAG_HEAP;
+    SHARED_HANDLE(SharedTexture, SemaphoreHandle) = SharedTexture_CreateSemaphore();
+
+    if (SharedTexture_Publish(&SharedTexture, Name))
+        return SharedTexture;
+
+    SharedTexture_Close(SharedTexture);
+    return (shared_texture) { .Format = SHARED_TEXTURE_NONE };
+}
+
+static void SharedTexture_CloseHandles(shared_texture SharedTexture)
+{
+    SharedTexture_StopSend(SharedTexture.Sender);
+    SharedTexture_CloseHandle(SHARED_HANDLE(SharedTexture, MemoryHandle));
+    SharedTexture_CloseHandle(SHARED_HANDLE(SharedTexture, SemaphoreHandle));
+}
+
+void SHARED_TEXTURE_EXPORT SharedTexture_Close(shared_texture SharedTexture)
+{
+    SharedTexture_CloseHandles(SharedTexture);
+    SharedTexture_UnmapControl(SharedTexture.Control, SHARED_HANDLE(SharedTexture, ControlHandle));
+}
+
+//
+// BUFFER
+//
+
+shared_buffer SHARED_TEXTURE_EXPORT SharedBuffer_Create(const char *Name, uint64_t Size)
+{
+    if (!SharedTexture_RequireDevice())
+        return (shared_buffer) { 0 };
+
+    VkBuffer Buffer = VK_NULL_HANDLE;
+    VkBufferCreateInfo BufferCreateInfo = SharedBuffer_ToVulkanBufferCreateInfo(Size,
+        &(VkExternalMemoryBufferCreateInfo){
+            .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+            .handleTypes = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE
+        }
+    );
+    if (VK.Funcs.vkCreateBuffer(VK.Device, &BufferCreateInfo, 0, &Buffer) != VK_SUCCESS)
+        return (shared_buffer) { 0 };
+
+    VkMemoryRequirements MemReqs;
+    VK.Funcs.vkGetBufferMemoryRequirements(VK.Device, Buffer, &MemReqs);
+    VK.Funcs.vkDestroyBuffer(VK.Device, Buffer, 0);
+    uint32_t MemoryTypeIndex = Vulkan_FindPhysicalDeviceMemoryIndex(VK.PhysicalDevice,
+        MemReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (MemoryTypeIndex == UINT32_MAX)
+        return (shared_buffer) { 0 };
+    VkDeviceMemory Memory = SharedTexture_AllocateExportableMemory(MemReqs.size, MemoryTypeIndex, VK_NULL_HANDLE, VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE);
+    if (Memory == VK_NULL_HANDLE)
+        return (shared_buffer) { 0 };
+
+    shared_buffer SharedBuffer = {
+        .Size = Size,
+        .MemorySize = MemReqs.size,
+    };
+    SHARED_HANDLE(SharedBuffer, MemoryHandle) = SharedTexture_ExportMemory(Memory, VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE);
+    SHARED_HANDLE(SharedBuffer, SemaphoreHandle) = SharedTexture_CreateSemaphore();
+    VK.Funcs.vkFreeMemory(VK.Device, Memory, 0);
+
+    shared_handle Handles[] = { SHARED_HANDLE(SharedBuffer, MemoryHandle), SHARED_HANDLE(SharedBuffer, SemaphoreHandle) };
+    SharedBuffer.Sender = SharedTexture_Send(BUFFER_PIPE_PREFIX, Name, &SharedBuffer, sizeof(shared_buffer), 2, Handles);
+    if (SharedBuffer.Sender)
+        return SharedBuffer;
+
+    SharedBuffer_Close(SharedBuffer);
+    return (shared_buffer) { 0 };
+}
+
+shared_buffer SHARED_TEXTURE_EXPORT SharedBuffer_Open(const char *Name)
+{
+    shared_buffer SharedBuffer = { 0 };
+    shared_handle *Handles[] = { &SHARED_HANDLE(SharedBuffer, MemoryHandle), &SHARED_HANDLE(SharedBuffer, SemaphoreHandle) };
+    if (SharedTexture_Receive(BUFFER_PIPE_PREFIX, Name, &SharedBuffer, sizeof(shared_buffer), 2, Handles))
+    {
+        SharedBuffer.Sender = NULL;
+        return SharedBuffer;
+    }
+
+    return (shared_buffer) { 0 };
+}
+
+shared_buffer SHARED_TEXTURE_EXPORT SharedBuffer_OpenOrCreate(const char *Name, uint64_t Size)
+{
+    shared_buffer SharedBuffer = SharedBuffer_Open(Name);
+    if (SharedBuffer.Size == 0)
+        SharedBuffer = SharedBuffer_Create(Name, Size);
+    return SharedBuffer;
+}
+
+void SHARED_TEXTURE_EXPORT SharedBuffer_Close(shared_buffer SharedBuffer)
+{
+    SharedTexture_StopSend(SharedBuffer.Sender);
+    SharedTexture_CloseHandle(SHARED_HANDLE(SharedBuffer, MemoryHandle));
+    SharedTexture_CloseHandle(SHARED_HANDLE(SharedBuffer, SemaphoreHandle));
 }
 
 shared_texture SharedTexture_OpenOrCreate(const char *Name, int32_t Width, int32_t Height, uint32_t Format)
@@ -332,4 +2356,8 @@ shared_texture SharedTexture_OpenOrCreate(const char *Name, int32_t Width, int32
     return SharedTexture;
 }
 
+#include "convert.c"
+#include "copy.c"
+#include "record.c"
+#include "replay.c"
 #include "unity.c"
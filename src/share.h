@@ -7,71 +7,385 @@
   #define VC_EXTRALEAN
   #define WIN32_LEAN_AND_MEAN
   #include <windows.h>
+#else
+  #include <unistd.h>
 #endif
 
 #include <stdint.h>
 #include <stdbool.h>
 #include <malloc.h>
+#include <string.h>
+
+#if defined(_WIN32)
+typedef HANDLE shared_handle;
+  #define SHARED_HANDLE(Object, Name) (Object).Win32.Name
+  #define SHARED_HANDLE_NONE NULL
+#else
+typedef int shared_handle;
+  #define SHARED_HANDLE(Object, Name) (Object).Posix.Name
+  #define SHARED_HANDLE_NONE -1
+#endif
 
 typedef enum shared_texture_format
 {
     SHARED_TEXTURE_NONE = 0,
     SHARED_TEXTURE_RGBA8,
     SHARED_TEXTURE_DEPTH,
+    SHARED_TEXTURE_RGBA8_SRGB,
+    SHARED_TEXTURE_RGBA8_UINT,
+    SHARED_TEXTURE_NV12,        // Y plane, interleaved CbCr plane at half resolution
+    SHARED_TEXTURE_P010,        // NV12 with 10 bits in the high bits of 16
+    SHARED_TEXTURE_I420,        // Y, Cb and Cr planes, chroma at half resolution
+    SHARED_TEXTURE_RGBA16F,     // scRGB and other extended range content
+    SHARED_TEXTURE_RGB10A2,     // HDR10
 } shared_texture_format;
 
+// Multi-planar YCbCr formats are 2D, linear and sampled or copied only. Planes
+// live in one allocation at Planes[i].Offset.
+#define SHARED_TEXTURE_IS_YCBCR(Format) ((Format) >= SHARED_TEXTURE_NV12 && (Format) <= SHARED_TEXTURE_I420)
+
+#define SHARED_TEXTURE_FORMAT_BIT(Format) (1u << (Format))
+
+typedef enum shared_texture_type
+{
+    SHARED_TEXTURE_2D = 0,
+    SHARED_TEXTURE_2D_ARRAY,
+    SHARED_TEXTURE_CUBE,    // Layers is a multiple of 6, more than 6 makes a cube array
+    SHARED_TEXTURE_3D,
+} shared_texture_type;
+
+typedef enum shared_texture_flags
+{
+    SHARED_TEXTURE_FLAG_HEAP = 0x1,     // bound at Offset into a shared_texture_heap, carries no memory handle
+    SHARED_TEXTURE_FLAG_DEDICATED = 0x2, // memory is a dedicated allocation, imports have to be dedicated as well
+    SHARED_TEXTURE_FLAG_DMA_BUF = 0x4,  // Linux only, memory is a dma-buf laid out as Modifier and Planes
+    SHARED_TEXTURE_FLAG_HOST = 0x8,     // linear and host visible, Planes[0] gives the row pitch, see SharedTexture_Map
+    SHARED_TEXTURE_FLAG_CPU = 0x10,     // plain shared memory without a GPU, mapped with SharedTexture_Map only
+    SHARED_TEXTURE_FLAG_HUGE_PAGES = 0x20, // CPU memory is backed by huge pages, Size is a multiple of them
+} shared_texture_flags;
+
+// What the texture is used for, by the producer and every consumer together.
+// Fewer bits let drivers keep compression on, e.g. for read-only textures.
+typedef enum shared_texture_usage
+{
+    SHARED_TEXTURE_USAGE_SAMPLED = 0x1,
+    SHARED_TEXTURE_USAGE_RENDER = 0x2,          // color or depth attachment
+    SHARED_TEXTURE_USAGE_STORAGE = 0x4,         // compute and image load/store
+    SHARED_TEXTURE_USAGE_TRANSFER_SRC = 0x8,
+    SHARED_TEXTURE_USAGE_TRANSFER_DST = 0x10,
+    SHARED_TEXTURE_USAGE_MUTABLE = 0x20,        // views may reinterpret the format
+    SHARED_TEXTURE_USAGE_DEFAULT = 0x3B,        // everything but storage
+} shared_texture_usage;
+
+// Tags describing what the producer wrote, so consumers only convert when they
+// have to, see SharedTexture_NeedsColorConversion. 0 is plain sRGB content.
+typedef enum shared_texture_primaries
+{
+    SHARED_TEXTURE_PRIMARIES_BT709 = 0,     // same as sRGB
+    SHARED_TEXTURE_PRIMARIES_BT2020,
+} shared_texture_primaries;
+
+typedef enum shared_texture_transfer
+{
+    SHARED_TEXTURE_TRANSFER_SRGB = 0,
+    SHARED_TEXTURE_TRANSFER_LINEAR,
+    SHARED_TEXTURE_TRANSFER_PQ,             // SMPTE ST 2084
+    SHARED_TEXTURE_TRANSFER_HLG,
+} shared_texture_transfer;
+
+// Layout the last signal left the image in, so the next waiter transitions
+// from it instead of discarding the contents. Maps onto VkImageLayout and the
+// GL_LAYOUT_*_EXT enums of GL_EXT_semaphore.
+typedef enum shared_texture_layout
+{
+    SHARED_TEXTURE_LAYOUT_UNDEFINED = 0,    // nothing published into the storage yet
+    SHARED_TEXTURE_LAYOUT_GENERAL,
+    SHARED_TEXTURE_LAYOUT_COLOR_ATTACHMENT,
+    SHARED_TEXTURE_LAYOUT_DEPTH_ATTACHMENT,
+    SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY,
+    SHARED_TEXTURE_LAYOUT_TRANSFER_SRC,
+    SHARED_TEXTURE_LAYOUT_TRANSFER_DST,
+    SHARED_TEXTURE_LAYOUT_COUNT,
+} shared_texture_layout;
+
+typedef struct shared_texture_create_info
+{
+    uint32_t Type;
+    uint32_t Format;
+    int32_t Width, Height;
+    int32_t Depth;          // 3D only, 0 is treated as 1
+    uint32_t Layers;        // 2D array and cube only, 0 is treated as 1
+    uint32_t Flags;         // SHARED_TEXTURE_FLAG_DMA_BUF, SHARED_TEXTURE_FLAG_HOST or SHARED_TEXTURE_FLAG_CPU, 2D only
+    uint32_t ModifierCount; // DRM format modifiers the consumers accept, e.g. from
+    const uint64_t *Modifiers; // eglQueryDmaBufModifiersEXT, 0 accepts any the driver offers
+    uint32_t Usage;         // shared_texture_usage of the producer, 0 is SHARED_TEXTURE_USAGE_DEFAULT
+    uint32_t ViewFormats;   // SHARED_TEXTURE_FORMAT_BIT of every format views may reinterpret the texture as
+    uint32_t Primaries;     // shared_texture_primaries
+    uint32_t Transfer;      // shared_texture_transfer, SHARED_TEXTURE_RGBA8_SRGB requires SHARED_TEXTURE_TRANSFER_SRGB
+    uint32_t Samples;       // 2, 4 or 8 for multisampled 2D textures, 0 is treated as 1
+    uint32_t ResolveSlots;  // multisampled color only, single-sample ring resolved into on publish, see SharedTexture_ToResolve
+    uint32_t NumaNode;      // SHARED_TEXTURE_FLAG_CPU only, node + 1 to place the pages on, see SharedTexture_CurrentNumaNode
+} shared_texture_create_info;
+
+// Lives in named shared memory next to every shared texture, so producer and
+// consumers observe the same values without another round trip over the pipe.
+typedef struct shared_texture_control
+{
+    volatile int64_t Generation;        // bumped by the producer whenever new storage is published
+    volatile int32_t Usage;             // usage consumers asked for, see SharedTexture_RequestUsage
+    volatile int32_t CpuSignal;         // SHARED_TEXTURE_FLAG_CPU on Linux, futex that is 1 while signalled
+    volatile int64_t Signal;            // layout and resolve slot of the latest signal, see SharedTexture_StoreSignal
+} shared_texture_control;
+
+// Serves the descriptor to consumers, process local to the producer.
+typedef struct shared_texture_sender shared_texture_sender;
+
+typedef struct shared_texture_plane
+{
+    uint64_t Offset;
+    uint64_t RowPitch;
+} shared_texture_plane;
+
 typedef struct shared_texture
 {
     uint32_t Format;
     int32_t Width, Height;
     uint64_t Size;
+    uint32_t Type;
+    int32_t Depth;
+    uint32_t Layers;
+    uint32_t Flags;
+    uint64_t Offset;
+    int64_t Generation;
+    shared_texture_control *Control;    // process local, mapped by Create and Open
+    shared_texture_sender *Sender;      // process local, of the producer's generation
+    uint64_t Modifier;                  // DRM format modifier, SHARED_TEXTURE_FLAG_DMA_BUF only
+    uint32_t PlaneCount;
+    shared_texture_plane Planes[4];
+    uint32_t Usage;
+    uint32_t ViewFormats;
+    uint32_t Primaries;
+    uint32_t Transfer;
+    uint32_t Samples;
+    uint32_t ResolveSlots;
+    uint64_t ResolveOffset;             // of the resolve ring in the texture's memory
+    uint32_t NumaNode;
 #if defined(_WIN32)
     struct
     {
         HANDLE MemoryHandle;
         HANDLE SemaphoreHandle;
+        HANDLE ControlHandle;           // process local
     } Win32;
 #else
     struct
     {
         int MemoryHandle;
         int SemaphoreHandle;
+        int ControlHandle;              // process local
     } Posix;
 #endif
 } shared_texture;
 
-#define SHARED_TEXTURE_EXPORT __declspec(dllexport) __cdecl
+// CPU access to a SHARED_TEXTURE_FLAG_HOST texture. The memory is imported
+// into the library's own Vulkan device, so no graphics context is needed.
+// SHARED_TEXTURE_FLAG_CPU textures are mapped directly and HostWait/HostSignal
+// hand them between processes without any device.
+typedef struct shared_texture_mapping
+{
+    uint8_t *Data;          // texel (0, 0)
+    uint64_t RowPitch;
+    void *Internal;
+} shared_texture_mapping;
+
+// Linear memory shared like a texture, e.g. vertex or particle storage buffers.
+// A Size of 0 marks a failed create or open.
+typedef struct shared_buffer
+{
+    uint64_t Size;
+    uint64_t MemorySize;
+    shared_texture_sender *Sender;      // process local, producer only
+#if defined(_WIN32)
+    struct
+    {
+        HANDLE MemoryHandle;
+        HANDLE SemaphoreHandle;
+    } Win32;
+#else
+    struct
+    {
+        int MemoryHandle;
+        int SemaphoreHandle;
+    } Posix;
+#endif
+} shared_buffer;
+
+// One exported allocation that many small shared textures are placed in,
+// so consumers import a single memory handle for all of them.
+typedef struct shared_texture_heap
+{
+    uint64_t Size;
+    uint64_t Used;
+    shared_texture_sender *Sender;      // process local, producer only
+#if defined(_WIN32)
+    struct
+    {
+        HANDLE MemoryHandle;
+    } Win32;
+#else
+    struct
+    {
+        int MemoryHandle;
+    } Posix;
+#endif
+} shared_texture_heap;
+
+#if defined(_WIN32)
+  #define SHARED_TEXTURE_EXPORT __declspec(dllexport) __cdecl
+#else
+  #define SHARED_TEXTURE_EXPORT __attribute__((visibility("default")))
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Returns false if no Vulkan device qualifies, unless SharedTexture_SetCpuFallback
+// was enabled before.
 bool SHARED_TEXTURE_EXPORT SharedTexture_Init(void);
+// SharedTexture_Init deferred to the first call that needs the device, e.g.
+// SharedTexture_Create, so processes that only open textures never create it.
+bool SHARED_TEXTURE_EXPORT SharedTexture_InitLazy(void);
+bool SHARED_TEXTURE_EXPORT SharedTexture_HasDevice(void);
+// Runs the uploads of SharedTexture_CreateFromHostPointer and SharedReplay and
+// the readbacks of SharedRecorder created afterwards on a dedicated transfer
+// queue, so they overlap with graphics work. Returns false without one.
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetAsyncTransfer(bool Enable);
+// Without a Vulkan device every texture is then created with
+// SHARED_TEXTURE_FLAG_CPU, while heaps and buffers fail. Off by default, set
+// it before SharedTexture_Init so that succeeds on GPU-less hosts.
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetCpuFallback(bool Enable);
 shared_texture SHARED_TEXTURE_EXPORT SharedTexture_Open(const char *Name);
 shared_texture SHARED_TEXTURE_EXPORT SharedTexture_Create(const char *Name, int32_t Width, int32_t Height, uint32_t Format);
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_CreateEx(const char *Name, const shared_texture_create_info *CreateInfo);
 shared_texture SHARED_TEXTURE_EXPORT SharedTexture_OpenOrCreate(const char *Name, int32_t Width, int32_t Height, uint32_t Format);
 void SHARED_TEXTURE_EXPORT SharedTexture_Close(shared_texture SharedTexture);
 
+// Producer: replaces the storage and publishes it as a new generation.
+bool SHARED_TEXTURE_EXPORT SharedTexture_Resize(shared_texture *SharedTexture, const char *Name, int32_t Width, int32_t Height);
+// Consumer: picks up a newer generation if one was published. Returns true if
+// the texture changed and its OpenGL/Vulkan objects have to be imported again.
+bool SHARED_TEXTURE_EXPORT SharedTexture_Reopen(shared_texture *SharedTexture, const char *Name);
+// Consumer: declares the shared_texture_usage it needs. Returns true if the
+// current storage already allows it, otherwise wait for the producer to
+// publish a new generation and pick it up with SharedTexture_Reopen.
+bool SHARED_TEXTURE_EXPORT SharedTexture_RequestUsage(shared_texture *SharedTexture, uint32_t Usage);
+// Producer: reallocates with the union of all requested usage if consumers
+// asked for more. Returns true if a new generation was published.
+bool SHARED_TEXTURE_EXPORT SharedTexture_UpdateUsage(shared_texture *SharedTexture, const char *Name);
+// The single-sample resolve ring of a multisampled texture as a 2D array with
+// ResolveSlots layers, at Offset in the same memory and synchronized by the same
+// semaphore. It borrows the handles, do not close it.
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_ToResolve(shared_texture SharedTexture);
+// Consumer: returns false if sampled values already are in the given
+// primaries and transfer function, so tone mapping and gamma can be skipped.
+// Sampling SHARED_TEXTURE_RGBA8_SRGB decodes to SHARED_TEXTURE_TRANSFER_LINEAR.
+bool SHARED_TEXTURE_EXPORT SharedTexture_NeedsColorConversion(shared_texture SharedTexture, uint32_t Primaries, uint32_t Transfer);
+
+bool SHARED_TEXTURE_EXPORT SharedTexture_Map(shared_texture SharedTexture, shared_texture_mapping *Mapping);
+void SHARED_TEXTURE_EXPORT SharedTexture_Unmap(shared_texture_mapping *Mapping);
+// Block until the GPU side signalled the texture / hand it back after CPU access.
+bool SHARED_TEXTURE_EXPORT SharedTexture_HostWait(shared_texture_mapping *Mapping);
+bool SHARED_TEXTURE_EXPORT SharedTexture_HostSignal(shared_texture_mapping *Mapping);
+// Producer: creates Name from CreateInfo, a 2D texture in one of the formats
+// of SHARED_TEXTURE_FLAG_CPU, whose frames come from Height rows of RowPitch
+// bytes at Pointer. Mapping->Data is Pointer: write a frame there and call
+// SharedTexture_HostSignal, the GPU copies it straight from those pages
+// through VK_EXT_external_memory_host, without a staging upload. HostWait
+// returns once Pointer may be written again. Pointer has to stay valid until
+// SharedTexture_Unmap and is only imported if it is page aligned and the frame,
+// up to the end of its last row, is a whole number of pages. Otherwise, and
+// without a device, HostSignal copies the frame.
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_CreateFromHostPointer(const char *Name, const shared_texture_create_info *CreateInfo,
+                                                                        const void *Pointer, uint64_t RowPitch, shared_texture_mapping *Mapping);
+// Copies Height rows of RowSize bytes, e.g. into or out of a mapping. Large
+// copies are split into cache-sized stripes shared by the calling thread and
+// a pool of workers, memory bandwidth of one core is not enough for 8K frames.
+void SHARED_TEXTURE_EXPORT SharedTexture_HostCopy(void *Dst, int64_t DstPitch, const void *Src, int64_t SrcPitch, uint64_t RowSize, int32_t Height);
+// Workers besides the calling thread, by default half the hardware threads
+// minus one. Returns false once the pool is running.
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetCopyThreads(uint32_t Count);
+// NUMA node of the calling thread as shared_texture_create_info.NumaNode, 0 if unknown.
+uint32_t SHARED_TEXTURE_EXPORT SharedTexture_CurrentNumaNode(void);
+
+shared_texture_heap SHARED_TEXTURE_EXPORT SharedTextureHeap_Create(const char *Name, uint64_t Size);
+shared_texture_heap SHARED_TEXTURE_EXPORT SharedTextureHeap_Open(const char *Name);
+void SHARED_TEXTURE_EXPORT SharedTextureHeap_Close(shared_texture_heap Heap);
+shared_texture SHARED_TEXTURE_EXPORT SharedTexture_CreateInHeap(shared_texture_heap *Heap, const char *Name, const shared_texture_create_info *CreateInfo);
+
+shared_buffer SHARED_TEXTURE_EXPORT SharedBuffer_Create(const char *Name, uint64_t Size);
+shared_buffer SHARED_TEXTURE_EXPORT SharedBuffer_Open(const char *Name);
+shared_buffer SHARED_TEXTURE_EXPORT SharedBuffer_OpenOrCreate(const char *Name, uint64_t Size);
+void SHARED_TEXTURE_EXPORT SharedBuffer_Close(shared_buffer SharedBuffer);
+
 #ifdef __cplusplus
 }
 #endif
 
+// Whoever signals the texture's semaphore stores the layout it released the
+// texture in, and the producer of a multisampled texture the ring slot it
+// resolved into, once the submit that signals returned. Both are one word, so
+// a waiter never pairs the layout of one signal with the slot of another. Read
+// them while building the wait, which comes after that submit.
+static void SharedTexture_StoreSignal(shared_texture SharedTexture, shared_texture_layout Layout, uint32_t ResolveSlot);
+static void SharedTexture_StoreLayout(shared_texture SharedTexture, shared_texture_layout Layout);
+static shared_texture_layout SharedTexture_SignalLayout(shared_texture SharedTexture);
+static uint32_t SharedTexture_ResolveSlot(shared_texture SharedTexture);
+// Bytes per texel of single-plane formats, 0 for YCbCr.
+static uint32_t SharedTexture_CpuTexelSize(uint32_t Format);
+
 #if defined(SHARED_TEXTURE_OPENGL)
 
-#include <gl/gl.h>
-#include <gl/glext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
 
 typedef struct gl_shared_texture
 {
-    GLuint Texture;
+    GLuint Texture;         // luma plane of YCbCr textures
     GLuint Memory;
     GLuint Semaphore;
+    GLuint Chroma[2];       // YCbCr only, the CbCr plane or the Cb and Cr planes
+    GLuint Resolve;         // multisampled only, the resolve ring, see SharedTexture_ToResolve
+    shared_texture_control *Control; // of the shared texture, for the layout handshake
 } gl_shared_texture;
 
+typedef struct gl_shared_heap
+{
+    GLuint Memory;
+} gl_shared_heap;
+
 static gl_shared_texture SharedTexture_ToOpenGL(shared_texture SharedTexture);
+static gl_shared_heap SharedTextureHeap_ToOpenGL(shared_texture_heap Heap);
+static gl_shared_texture SharedTexture_ToOpenGLInHeap(shared_texture SharedTexture, gl_shared_heap Heap);
+static void SharedTextureHeap_DestroyOpenGLHeap(gl_shared_heap Heap);
+
+typedef struct gl_shared_buffer
+{
+    GLuint Buffer;
+    GLuint Memory;
+    GLuint Semaphore;
+} gl_shared_buffer;
+
+static gl_shared_buffer SharedBuffer_ToOpenGL(shared_buffer SharedBuffer);
+static void SharedBuffer_DestroyOpenGLBuffer(gl_shared_buffer SharedBuffer);
+static bool SharedBuffer_OpenGLWait(gl_shared_buffer SharedBuffer);
+static void SharedBuffer_OpenGLSignal(gl_shared_buffer SharedBuffer);
 static bool SharedTexture_OpenGLWait(gl_shared_texture SharedTexture);
 static void SharedTexture_OpenGLSignal(gl_shared_texture SharedTexture);
+static GLenum SharedTexture_ToOpenGLLayout(shared_texture_layout Layout);
 static GLuint SharedTexture_ToOpenGLFormat(shared_texture_format Format);
+static GLenum SharedTexture_ToOpenGLTarget(shared_texture SharedTexture);
+static GLuint SharedTexture_CreateOpenGLView(gl_shared_texture GLSharedTexture, shared_texture SharedTexture, shared_texture_format Format);
 
 #endif // defined(SHARED_TEXTURE_OPENGL)
 
@@ -88,11 +402,119 @@ typedef struct vk_shared_texture
     VkImage Image;
     VkDeviceMemory Memory;
     VkSemaphore Semaphore;
+    VkImage Resolve;        // multisampled only, the resolve ring, see SharedTexture_ToResolve
 } vk_shared_texture;
 
+typedef struct vk_shared_heap
+{
+    VkDeviceMemory Memory;
+} vk_shared_heap;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Instead of SharedTexture_Init, creates textures on the application's device.
+// It needs the external memory and semaphore extensions of the platform, and
+// VK_EXT_external_memory_host and VK_EXT_image_drm_format_modifier are used if
+// enabled. GetInstanceProcAddr may be NULL to load the Vulkan loader. Fails
+// once the library created a device of its own, with SharedTexture_InitLazy
+// it has to come before the first texture.
+bool SHARED_TEXTURE_EXPORT SharedTexture_InitWithDevice(VkInstance Instance, VkPhysicalDevice PhysicalDevice, VkDevice Device,
+                                                         PFN_vkGetInstanceProcAddr GetInstanceProcAddr);
+// The queue SharedTexture_Map, SharedTexture_CreateFromHostPointer, SharedReplay
+// and SharedRecorder submit to on the application's device, they fail without
+// one. They submit from the calling thread, which must not race other submits
+// to Queue. SharedReplay and SharedRecorder need timeline semaphores.
+bool SHARED_TEXTURE_EXPORT SharedTexture_SetDeviceQueue(VkQueue Queue, uint32_t QueueFamilyIndex);
+
+#ifdef __cplusplus
+}
+#endif
+
 static vk_shared_texture SharedTexture_ToVulkan(shared_texture SharedTexture, VkDevice Device, VkPhysicalDevice PhysicalDevice);
+static vk_shared_heap SharedTextureHeap_ToVulkan(shared_texture_heap Heap, VkDevice Device, VkPhysicalDevice PhysicalDevice);
+static vk_shared_texture SharedTexture_ToVulkanInHeap(shared_texture SharedTexture, vk_shared_heap Heap, VkDevice Device);
+static void SharedTextureHeap_DestroyVulkanHeap(vk_shared_heap Heap, VkDevice Device);
+static uint32_t SharedTextureHeap_FindVulkanMemoryType(VkDevice Device, VkPhysicalDevice PhysicalDevice);
+
+typedef struct vk_shared_buffer
+{
+    VkBuffer Buffer;
+    VkDeviceMemory Memory;
+    VkSemaphore Semaphore;
+} vk_shared_buffer;
+
+static vk_shared_buffer SharedBuffer_ToVulkan(shared_buffer SharedBuffer, VkDevice Device, VkPhysicalDevice PhysicalDevice);
+static void SharedBuffer_DestroyVulkanBuffer(vk_shared_buffer SharedBuffer, VkDevice Device);
+static VkBufferCreateInfo SharedBuffer_ToVulkanBufferCreateInfo(uint64_t Size, const void *pNext);
 static void SharedTexture_DestroyVulkanTexture(vk_shared_texture SharedTexture, VkDevice Device);
 static VkFormat SharedTexture_ToVulkanFormat(shared_texture_format Format);
+static VkImageViewType SharedTexture_ToVulkanImageViewType(shared_texture SharedTexture);
+static VkImageCreateInfo SharedTexture_ToVulkanImageCreateInfo(shared_texture SharedTexture, const void *pNext);
+static VkImageView SharedTexture_CreateVulkanView(vk_shared_texture VKSharedTexture, shared_texture SharedTexture, shared_texture_format Format, VkDevice Device);
+static VkSamplerYcbcrConversion SharedTexture_CreateVulkanYcbcrConversion(shared_texture SharedTexture, VkDevice Device);
+static VkImageView SharedTexture_CreateVulkanYcbcrView(vk_shared_texture VKSharedTexture, shared_texture SharedTexture, VkSamplerYcbcrConversion Conversion, VkDevice Device);
+static VkSampler SharedTexture_CreateVulkanYcbcrSampler(VkSamplerYcbcrConversion Conversion, VkDevice Device);
+static VkColorSpaceKHR SharedTexture_ToVulkanColorSpace(shared_texture SharedTexture);
+static uint32_t SharedTexture_VulkanRecordResolve(shared_texture *SharedTexture, vk_shared_texture VKSharedTexture, VkCommandBuffer CommandBuffer, VkImageLayout Layout);
+static VkImageLayout SharedTexture_ToVulkanLayout(shared_texture_layout Layout);
+static shared_texture_layout SharedTexture_FromVulkanLayout(VkImageLayout Layout);
+static VkImageLayout SharedTexture_VulkanLayout(shared_texture SharedTexture);
+static VkImageMemoryBarrier SharedTexture_VulkanAcquire(shared_texture SharedTexture, vk_shared_texture VKSharedTexture, uint32_t QueueFamilyIndex, VkImageLayout Layout);
+static VkImageMemoryBarrier SharedTexture_VulkanRelease(shared_texture SharedTexture, vk_shared_texture VKSharedTexture, uint32_t QueueFamilyIndex, VkImageLayout Layout);
+
+// Formats views may use, chained into every VkImageCreateInfo of the texture.
+typedef struct vk_shared_format_list
+{
+    VkImageFormatListCreateInfo CreateInfo;
+    VkFormat Formats[8];
+} vk_shared_format_list;
+
+#define SHARED_TEXTURE_MAX_COPY_TARGETS 16
+
+// Copies of a shared texture into images of the consumer, e.g. its swapchain.
+// The commands for every destination are recorded once into a secondary
+// command buffer and replayed from then on. Secondaries are only re-recorded
+// once the caller said they are idle: a new import of the texture re-records
+// all of them, so the old import must no longer be in use, as before
+// destroying it, and destroyed destinations have to be dropped with
+// SharedTexture_InvalidateVulkanCopy.
+typedef struct vk_shared_copy_target
+{
+    VkImage Image;
+    VkFormat Format;
+    int32_t Width, Height;
+    VkImageLayout OldLayout, NewLayout;
+    bool FlipY;
+    VkImageLayout AcquireLayout, ReleaseLayout; // of the shared image
+    VkCommandBuffer CommandBuffer;
+} vk_shared_copy_target;
+
+typedef struct vk_shared_copy
+{
+    VkDevice Device;
+    VkCommandPool CommandPool;
+    uint32_t QueueFamilyIndex;
+    VkImage Source;         // the shared image the targets were recorded for
+    VkImageLayout Layout;   // the shared image is handed back in, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL by default
+    uint32_t TargetCount;
+    vk_shared_copy_target Targets[SHARED_TEXTURE_MAX_COPY_TARGETS];
+} vk_shared_copy;
+
+static bool SharedTexture_CreateVulkanCopy(vk_shared_copy *Copy, VkDevice Device, uint32_t QueueFamilyIndex);
+static void SharedTexture_DestroyVulkanCopy(vk_shared_copy *Copy);
+static void SharedTexture_InvalidateVulkanCopy(vk_shared_copy *Copy, VkImage Image);
+static bool SharedTexture_VulkanRecordCopy(vk_shared_copy *Copy, VkCommandBuffer CommandBuffer, shared_texture SharedTexture, vk_shared_texture VKSharedTexture,
+                                           VkImage Image, VkFormat Format, int32_t Width, int32_t Height, VkImageLayout OldLayout, VkImageLayout NewLayout, bool FlipY);
+
+static const void *SharedTexture_ToVulkanFormatList(shared_texture SharedTexture, vk_shared_format_list *FormatList, const void *pNext);
+static VkImageUsageFlags SharedTexture_ToVulkanImageUsage(shared_texture SharedTexture);
+static VkMemoryRequirements SharedTexture_GetVulkanMemoryRequirements(VkImage Image, VkDevice Device, bool *Dedicated, bool *Required);
+static uint32_t SharedTexture_FindVulkanMemoryType(shared_texture SharedTexture, uint32_t MemoryTypeBits, VkPhysicalDevice PhysicalDevice);
+
+// From vk_utils.h, which the including file has to pull in as well.
+static int32_t Vulkan_FindPhysicalDeviceMemoryIndex(VkPhysicalDevice PhysicalDevice, uint32_t TypeFilter, VkMemoryPropertyFlagBits Properties);
 
 #endif // defined(SHARED_TEXTURE_VULKAN)
 
@@ -102,14 +524,78 @@ static VkFormat SharedTexture_ToVulkanFormat(shared_texture_format Format);
 //                    //
 ////////////////////////
 
+static int64_t SharedTexture_LoadSignal(shared_texture_control *Control)
+{
+#if defined(_WIN32)
+    return InterlockedCompareExchange64(&Control->Signal, 0, 0);
+#else
+    return __atomic_load_n(&Control->Signal, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void SharedTexture_StoreSignal(shared_texture SharedTexture, shared_texture_layout Layout, uint32_t ResolveSlot)
+{
+    if (!SharedTexture.Control)
+        return;
+    int64_t Signal = (int64_t)((uint64_t)ResolveSlot << 32 | (uint32_t)Layout);
+#if defined(_WIN32)
+    InterlockedExchange64(&SharedTexture.Control->Signal, Signal);
+#else
+    __atomic_store_n(&SharedTexture.Control->Signal, Signal, __ATOMIC_RELEASE);
+#endif
+}
+
+// Keeps the resolve slot, for consumers handing the texture back.
+static void SharedTexture_StoreLayout(shared_texture SharedTexture, shared_texture_layout Layout)
+{
+    SharedTexture_StoreSignal(SharedTexture, Layout, SharedTexture_ResolveSlot(SharedTexture));
+}
+
+// SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY without a control block.
+static shared_texture_layout SharedTexture_SignalLayout(shared_texture SharedTexture)
+{
+    if (!SharedTexture.Control)
+        return SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY;
+    uint32_t Layout = (uint32_t)SharedTexture_LoadSignal(SharedTexture.Control);
+    return Layout < SHARED_TEXTURE_LAYOUT_COUNT ? (shared_texture_layout)Layout : SHARED_TEXTURE_LAYOUT_GENERAL;
+}
+
+static uint32_t SharedTexture_ResolveSlot(shared_texture SharedTexture)
+{
+    if (!SharedTexture.Control)
+        return 0;
+    return (uint32_t)((uint64_t)SharedTexture_LoadSignal(SharedTexture.Control) >> 32);
+}
+
+// YCbCr is left to the GPU, the CPU backend only holds single-plane formats.
+static uint32_t SharedTexture_CpuTexelSize(uint32_t Format)
+{
+    switch (Format)
+    {
+        case SHARED_TEXTURE_RGBA8:
+        case SHARED_TEXTURE_DEPTH:
+        case SHARED_TEXTURE_RGBA8_SRGB:
+        case SHARED_TEXTURE_RGBA8_UINT:
+        case SHARED_TEXTURE_RGB10A2:
+            return 4;
+        case SHARED_TEXTURE_RGBA16F:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
 #if defined(SHARED_TEXTURE_OPENGL)
 
 PFNGLCREATEMEMORYOBJECTSEXTPROC glCreateMemoryObjectsEXT;
 PFNGLIMPORTMEMORYWIN32HANDLEEXTPROC glImportMemoryWin32HandleEXT;
 PFNGLIMPORTMEMORYFDEXTPROC glImportMemoryFdEXT;
+PFNGLMEMORYOBJECTPARAMETERIVEXTPROC glMemoryObjectParameterivEXT;
 PFNGLCREATETEXTURESPROC glCreateTextures;
 PFNGLTEXTUREPARAMETERIPROC glTextureParameteri;
 PFNGLTEXTURESTORAGEMEM2DEXTPROC glTextureStorageMem2DEXT;
+PFNGLTEXTURESTORAGEMEM3DEXTPROC glTextureStorageMem3DEXT;
+PFNGLTEXTURESTORAGEMEM2DMULTISAMPLEEXTPROC glTextureStorageMem2DMultisampleEXT;
 PFNGLGENSEMAPHORESEXTPROC glGenSemaphoresEXT;
 PFNGLIMPORTSEMAPHOREWIN32HANDLEEXTPROC glImportSemaphoreWin32HandleEXT;
 PFNGLIMPORTSEMAPHOREFDEXTPROC glImportSemaphoreFdEXT;
@@ -117,6 +603,10 @@ PFNGLDELETEMEMORYOBJECTSEXTPROC glDeleteMemoryObjectsEXT;
 PFNGLDELETESEMAPHORESEXTPROC glDeleteSemaphoresEXT;
 PFNGLWAITSEMAPHOREEXTPROC glWaitSemaphoreEXT;
 PFNGLSIGNALSEMAPHOREEXTPROC glSignalSemaphoreEXT;
+PFNGLCREATEBUFFERSPROC glCreateBuffers;
+PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+PFNGLNAMEDBUFFERSTORAGEMEMEXTPROC glNamedBufferStorageMemEXT;
+PFNGLTEXTUREVIEWPROC glTextureView;
 
 static GLuint SharedTexture_ToOpenGLFormat(shared_texture_format Format)
 {
@@ -124,58 +614,299 @@ static GLuint SharedTexture_ToOpenGLFormat(shared_texture_format Format)
     {
         case SHARED_TEXTURE_RGBA8: return GL_RGBA8;
         case SHARED_TEXTURE_DEPTH: return GL_DEPTH_COMPONENT32F;
+        case SHARED_TEXTURE_RGBA8_SRGB: return GL_SRGB8_ALPHA8;
+        case SHARED_TEXTURE_RGBA8_UINT: return GL_RGBA8UI;
+        case SHARED_TEXTURE_RGBA16F: return GL_RGBA16F;
+        case SHARED_TEXTURE_RGB10A2: return GL_RGB10_A2;
+        default: break; // YCbCr has one texture per plane, see SharedTexture_CreateOpenGLPlane
     }
     return VK_FORMAT_UNDEFINED;
 }
 
-static gl_shared_texture SharedTexture_ToOpenGL(shared_texture SharedTexture)
+static GLenum SharedTexture_ToOpenGLTarget(shared_texture SharedTexture)
+{
+    if (SharedTexture.Samples > 1)
+        return GL_TEXTURE_2D_MULTISAMPLE;
+    switch (SharedTexture.Type)
+    {
+        case SHARED_TEXTURE_2D_ARRAY: return GL_TEXTURE_2D_ARRAY;
+        case SHARED_TEXTURE_CUBE: return SharedTexture.Layers > 6 ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_CUBE_MAP;
+        case SHARED_TEXTURE_3D: return GL_TEXTURE_3D;
+    }
+    return GL_TEXTURE_2D;
+}
+
+// GL has no multi-planar formats, every plane becomes its own linear texture.
+static GLuint SharedTexture_CreateOpenGLPlane(shared_texture SharedTexture, GLuint Memory, GLuint64 Offset, uint32_t Plane)
+{
+    GLenum Format = GL_R8;
+    GLsizei Width = SharedTexture.Width;
+    GLsizei Height = SharedTexture.Height;
+    if (SharedTexture.Format == SHARED_TEXTURE_NV12)
+        Format = Plane ? GL_RG8 : GL_R8;
+    if (SharedTexture.Format == SHARED_TEXTURE_P010)
+        Format = Plane ? GL_RG16 : GL_R16;
+    if (Plane)
+    {
+        Width /= 2;
+        Height /= 2;
+    }
+
+    GLuint Texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &Texture);
+    glTextureParameteri(Texture, GL_TEXTURE_TILING_EXT, GL_LINEAR_TILING_EXT);
+    glTextureStorageMem2DEXT(Texture, 1, Format, Width, Height, Memory, Offset + SharedTexture.Planes[Plane].Offset);
+    return Texture;
+}
+
+static GLuint SharedTexture_CreateOpenGLTexture(shared_texture SharedTexture, GLuint Memory, GLuint64 Offset)
 {
+    if (SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format))
+        return SharedTexture_CreateOpenGLPlane(SharedTexture, Memory, Offset, 0);
+
     GLuint Format = SharedTexture_ToOpenGLFormat(SharedTexture.Format);
 
+    GLuint Texture;
+    GLenum Target = SharedTexture_ToOpenGLTarget(SharedTexture);
+    glCreateTextures(Target, 1, &Texture);
+    if (Target == GL_TEXTURE_2D_MULTISAMPLE)
+    {
+        glTextureStorageMem2DMultisampleEXT(Texture, SharedTexture.Samples, Format, SharedTexture.Width, SharedTexture.Height, GL_TRUE, Memory, Offset);
+        return Texture;
+    }
+    glTextureParameteri(Texture, GL_TEXTURE_TILING_EXT,
+        (SharedTexture.Flags & SHARED_TEXTURE_FLAG_HOST) ? GL_LINEAR_TILING_EXT : GL_OPTIMAL_TILING_EXT);
+    switch (Target)
+    {
+        case GL_TEXTURE_2D:
+        case GL_TEXTURE_CUBE_MAP:
+            glTextureStorageMem2DEXT(Texture, 1, Format, SharedTexture.Width, SharedTexture.Height, Memory, Offset);
+            break;
+        case GL_TEXTURE_3D:
+            glTextureStorageMem3DEXT(Texture, 1, Format, SharedTexture.Width, SharedTexture.Height, SharedTexture.Depth, Memory, Offset);
+            break;
+        default:
+            glTextureStorageMem3DEXT(Texture, 1, Format, SharedTexture.Width, SharedTexture.Height, SharedTexture.Layers, Memory, Offset);
+            break;
+    }
+    return Texture;
+}
+
+static GLuint SharedTexture_ImportOpenGLMemory(shared_handle Handle, GLuint64 Size, bool Dedicated)
+{
     GLuint Memory;
     glCreateMemoryObjectsEXT(1, &Memory);
+    if (Dedicated)
+    {
+        GLint True = GL_TRUE;
+        glMemoryObjectParameterivEXT(Memory, GL_DEDICATED_MEMORY_OBJECT_EXT, &True);
+    }
 #if defined(_WIN32)
-    glImportMemoryWin32HandleEXT(Memory, SharedTexture.Size, GL_HANDLE_TYPE_OPAQUE_WIN32_EXT, SharedTexture.Win32.MemoryHandle);
+    glImportMemoryWin32HandleEXT(Memory, Size, GL_HANDLE_TYPE_OPAQUE_WIN32_EXT, Handle);
 #else
-    glImportMemoryFdEXT(Memory, SharedTexture.Size, GL_HANDLE_TYPE_OPAQUE_FD_EXT, SharedTexture.Posix.MemoryHandle);
+    // The import takes ownership of the descriptor, the shared texture keeps its own.
+    glImportMemoryFdEXT(Memory, Size, GL_HANDLE_TYPE_OPAQUE_FD_EXT, dup(Handle));
 #endif
+    return Memory;
+}
 
-    GLuint Texture;
-    glCreateTextures(GL_TEXTURE_2D, 1, &Texture);
-    glTextureParameteri(Texture, GL_TEXTURE_TILING_EXT, GL_OPTIMAL_TILING_EXT);
-    glTextureStorageMem2DEXT(Texture, 1, Format, SharedTexture.Width, SharedTexture.Height, Memory, 0);
-
+static GLuint SharedTexture_ImportOpenGLSemaphore(shared_handle Handle)
+{
     GLuint Semaphore;
     glGenSemaphoresEXT(1, &Semaphore);
 #if defined(_WIN32)
-    glImportSemaphoreWin32HandleEXT(Semaphore, GL_HANDLE_TYPE_OPAQUE_WIN32_EXT, SharedTexture.Win32.SemaphoreHandle);
+    glImportSemaphoreWin32HandleEXT(Semaphore, GL_HANDLE_TYPE_OPAQUE_WIN32_EXT, Handle);
 #else
-    glImportSemaphoreFdEXT(Semaphore, GL_HANDLE_TYPE_OPAQUE_FD_EXT, SharedTexture.Posix.SemaphoreHandle);
+    glImportSemaphoreFdEXT(Semaphore, GL_HANDLE_TYPE_OPAQUE_FD_EXT, dup(Handle));
 #endif
+    return Semaphore;
+}
+
+// GL lays linear textures out on its own and cannot be given the row pitch
+// Vulkan picked, so it only imports them where that pitch is tightly packed.
+static bool SharedTexture_OpenGLMatchesLinearLayout(shared_texture SharedTexture)
+{
+    if (SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format))
+    {
+        // Same plane formats and sizes as SharedTexture_CreateOpenGLPlane.
+        uint64_t TexelSize = SharedTexture.Format == SHARED_TEXTURE_P010 ? 2 : 1;
+        for (uint32_t Plane = 0; Plane < SharedTexture.PlaneCount && Plane < 3; ++Plane)
+        {
+            uint64_t Width = Plane ? SharedTexture.Width / 2 : SharedTexture.Width;
+            uint64_t Channels = Plane && SharedTexture.Format != SHARED_TEXTURE_I420 ? 2 : 1;
+            if (SharedTexture.Planes[Plane].RowPitch != Width * Channels * TexelSize)
+                return false;
+        }
+        return true;
+    }
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_HOST)
+        return SharedTexture.Planes[0].RowPitch == (uint64_t)SharedTexture.Width * SharedTexture_CpuTexelSize(SharedTexture.Format);
+    return true;
+}
+
+static gl_shared_texture SharedTexture_ToOpenGL(shared_texture SharedTexture)
+{
+    // GL_EXT_memory_object has no notion of DRM format modifiers, such textures
+    // are imported through EGL_EXT_image_dma_buf_import_modifiers instead.
+    // CPU textures have no GPU memory to import.
+    if ((SharedTexture.Flags & (SHARED_TEXTURE_FLAG_DMA_BUF | SHARED_TEXTURE_FLAG_CPU)) || !SharedTexture_OpenGLMatchesLinearLayout(SharedTexture))
+    {
+        gl_shared_texture None = { 0 };
+        return None;
+    }
+
+    GLuint Memory = SharedTexture_ImportOpenGLMemory(SHARED_HANDLE(SharedTexture, MemoryHandle), SharedTexture.Size,
+        (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DEDICATED) != 0);
 
     gl_shared_texture GLSharedTexture;
-    GLSharedTexture.Texture = Texture;
+    GLSharedTexture.Texture = SharedTexture_CreateOpenGLTexture(SharedTexture, Memory, 0);
     GLSharedTexture.Memory = Memory;
-    GLSharedTexture.Semaphore = Semaphore;
+    GLSharedTexture.Semaphore = SharedTexture_ImportOpenGLSemaphore(SHARED_HANDLE(SharedTexture, SemaphoreHandle));
+    GLSharedTexture.Chroma[0] = 0;
+    GLSharedTexture.Chroma[1] = 0;
+    for (uint32_t Plane = 1; SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format) && Plane < SharedTexture.PlaneCount && Plane < 3; ++Plane)
+        GLSharedTexture.Chroma[Plane - 1] = SharedTexture_CreateOpenGLPlane(SharedTexture, Memory, 0, Plane);
+    GLSharedTexture.Resolve = 0;
+    if (SharedTexture.ResolveSlots)
+    {
+        shared_texture Resolve = SharedTexture_ToResolve(SharedTexture);
+        GLSharedTexture.Resolve = SharedTexture_CreateOpenGLTexture(Resolve, Memory, Resolve.Offset);
+    }
+    GLSharedTexture.Control = SharedTexture.Control;
+    return GLSharedTexture;
+}
+
+static gl_shared_heap SharedTextureHeap_ToOpenGL(shared_texture_heap Heap)
+{
+    gl_shared_heap GLSharedHeap;
+    GLSharedHeap.Memory = SharedTexture_ImportOpenGLMemory(SHARED_HANDLE(Heap, MemoryHandle), Heap.Size, false);
+    return GLSharedHeap;
+}
+
+// The texture borrows the heap's memory object, destroy the heap after all its textures.
+static gl_shared_texture SharedTexture_ToOpenGLInHeap(shared_texture SharedTexture, gl_shared_heap Heap)
+{
+    gl_shared_texture GLSharedTexture;
+    GLSharedTexture.Texture = SharedTexture_CreateOpenGLTexture(SharedTexture, Heap.Memory, SharedTexture.Offset);
+    GLSharedTexture.Memory = 0;
+    GLSharedTexture.Semaphore = SharedTexture_ImportOpenGLSemaphore(SHARED_HANDLE(SharedTexture, SemaphoreHandle));
+    GLSharedTexture.Chroma[0] = 0;
+    GLSharedTexture.Chroma[1] = 0;
+    GLSharedTexture.Resolve = 0;
+    GLSharedTexture.Control = SharedTexture.Control;
     return GLSharedTexture;
 }
 
 static void SharedTexture_DestroyOpenGLTexture(gl_shared_texture GLSharedTexture)
 {
     glDeleteTextures(1, &GLSharedTexture.Texture);
-    glDeleteMemoryObjectsEXT(1, &GLSharedTexture.Memory);
+    glDeleteTextures(2, GLSharedTexture.Chroma);
+    glDeleteTextures(1, &GLSharedTexture.Resolve);
+    if (GLSharedTexture.Memory)
+        glDeleteMemoryObjectsEXT(1, &GLSharedTexture.Memory);
     glDeleteSemaphoresEXT(1, &GLSharedTexture.Semaphore);
 }
 
+// A new texture name sharing the storage of GLSharedTexture, read as Format.
+// Delete it with glDeleteTextures before the texture it views.
+static GLuint SharedTexture_CreateOpenGLView(gl_shared_texture GLSharedTexture, shared_texture SharedTexture, shared_texture_format Format)
+{
+    if (Format != SharedTexture.Format && !(SharedTexture.ViewFormats & SHARED_TEXTURE_FORMAT_BIT(Format)))
+        return 0;
+
+    GLenum Target = SharedTexture_ToOpenGLTarget(SharedTexture);
+    GLuint Layers = Target == GL_TEXTURE_3D ? 1 : SharedTexture.Layers;
+    GLuint View;
+    glGenTextures(1, &View);
+    glTextureView(View, Target, GLSharedTexture.Texture, SharedTexture_ToOpenGLFormat(Format), 0, 1, 0, Layers);
+    return View;
+}
+
+static void SharedTextureHeap_DestroyOpenGLHeap(gl_shared_heap GLSharedHeap)
+{
+    glDeleteMemoryObjectsEXT(1, &GLSharedHeap.Memory);
+}
+
+static GLuint SharedTexture_OpenGLTextures(gl_shared_texture GLSharedTexture, GLuint *Textures)
+{
+    GLuint Count = 0;
+    Textures[Count++] = GLSharedTexture.Texture;
+    for (int i = 0; i < 2; ++i)
+        if (GLSharedTexture.Chroma[i])
+            Textures[Count++] = GLSharedTexture.Chroma[i];
+    if (GLSharedTexture.Resolve)
+        Textures[Count++] = GLSharedTexture.Resolve;
+    return Count;
+}
+
+static GLenum SharedTexture_ToOpenGLLayout(shared_texture_layout Layout)
+{
+    switch (Layout)
+    {
+        case SHARED_TEXTURE_LAYOUT_UNDEFINED: return GL_NONE;
+        case SHARED_TEXTURE_LAYOUT_GENERAL: return GL_LAYOUT_GENERAL_EXT;
+        case SHARED_TEXTURE_LAYOUT_COLOR_ATTACHMENT: return GL_LAYOUT_COLOR_ATTACHMENT_EXT;
+        case SHARED_TEXTURE_LAYOUT_DEPTH_ATTACHMENT: return GL_LAYOUT_DEPTH_STENCIL_ATTACHMENT_EXT;
+        case SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY: return GL_LAYOUT_SHADER_READ_ONLY_EXT;
+        case SHARED_TEXTURE_LAYOUT_TRANSFER_SRC: return GL_LAYOUT_TRANSFER_SRC_EXT;
+        case SHARED_TEXTURE_LAYOUT_TRANSFER_DST: return GL_LAYOUT_TRANSFER_DST_EXT;
+        default: break;
+    }
+    return GL_LAYOUT_GENERAL_EXT;
+}
+
+// The layouts tell GL what the signaller left the image in, so it keeps the
+// contents. The resolve ring is always in SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY.
 static bool SharedTexture_OpenGLWait(gl_shared_texture GLSharedTexture)
 {
-    glWaitSemaphoreEXT(GLSharedTexture.Semaphore, 0, 0, 1, &GLSharedTexture.Texture, (GLenum[]){ GL_LAYOUT_SHADER_READ_ONLY_EXT });
+    GLuint Textures[4];
+    GLuint Count = SharedTexture_OpenGLTextures(GLSharedTexture, Textures);
+    GLenum Layout = SharedTexture_ToOpenGLLayout(SharedTexture_SignalLayout((shared_texture) { .Control = GLSharedTexture.Control }));
+    GLenum Layouts[4] = { Layout, Layout, Layout, Layout };
+    if (GLSharedTexture.Resolve)
+        Layouts[Count - 1] = GL_LAYOUT_SHADER_READ_ONLY_EXT;
+    glWaitSemaphoreEXT(GLSharedTexture.Semaphore, 0, 0, Count, Textures, Layouts);
     return glGetError() == GL_NO_ERROR;
 }
 
+// GL hands the texture over in SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY. The
+// layout is published behind the signal, waiters in other APIs still need the
+// GL commands flushed.
 static void SharedTexture_OpenGLSignal(gl_shared_texture GLSharedTexture)
 {
-    glSignalSemaphoreEXT(GLSharedTexture.Semaphore, 0, 0, 1, &GLSharedTexture.Texture, (GLenum[]){ GL_LAYOUT_SHADER_READ_ONLY_EXT });
+    GLuint Textures[4];
+    GLuint Count = SharedTexture_OpenGLTextures(GLSharedTexture, Textures);
+    GLenum Layouts[4] = { GL_LAYOUT_SHADER_READ_ONLY_EXT, GL_LAYOUT_SHADER_READ_ONLY_EXT, GL_LAYOUT_SHADER_READ_ONLY_EXT, GL_LAYOUT_SHADER_READ_ONLY_EXT };
+    glSignalSemaphoreEXT(GLSharedTexture.Semaphore, 0, 0, Count, Textures, Layouts);
+    SharedTexture_StoreLayout((shared_texture) { .Control = GLSharedTexture.Control }, SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY);
+}
+
+static gl_shared_buffer SharedBuffer_ToOpenGL(shared_buffer SharedBuffer)
+{
+    gl_shared_buffer GLSharedBuffer;
+    GLSharedBuffer.Memory = SharedTexture_ImportOpenGLMemory(SHARED_HANDLE(SharedBuffer, MemoryHandle), SharedBuffer.MemorySize, false);
+    glCreateBuffers(1, &GLSharedBuffer.Buffer);
+    glNamedBufferStorageMemEXT(GLSharedBuffer.Buffer, SharedBuffer.Size, GLSharedBuffer.Memory, 0);
+    GLSharedBuffer.Semaphore = SharedTexture_ImportOpenGLSemaphore(SHARED_HANDLE(SharedBuffer, SemaphoreHandle));
+    return GLSharedBuffer;
+}
+
+static void SharedBuffer_DestroyOpenGLBuffer(gl_shared_buffer GLSharedBuffer)
+{
+    glDeleteBuffers(1, &GLSharedBuffer.Buffer);
+    glDeleteMemoryObjectsEXT(1, &GLSharedBuffer.Memory);
+    glDeleteSemaphoresEXT(1, &GLSharedBuffer.Semaphore);
+}
+
+static bool SharedBuffer_OpenGLWait(gl_shared_buffer GLSharedBuffer)
+{
+    glWaitSemaphoreEXT(GLSharedBuffer.Semaphore, 1, &GLSharedBuffer.Buffer, 0, 0, 0);
+    return glGetError() == GL_NO_ERROR;
+}
+
+static void SharedBuffer_OpenGLSignal(gl_shared_buffer GLSharedBuffer)
+{
+    glSignalSemaphoreEXT(GLSharedBuffer.Semaphore, 1, &GLSharedBuffer.Buffer, 0, 0, 0);
 }
 
 #endif // defined(SHARED_TEXTURE_OPENGL)
@@ -195,14 +926,38 @@ static void SharedTexture_OpenGLSignal(gl_shared_texture GLSharedTexture)
 #endif
 
 PFN_vkCreateImage vkCreateImage;
+PFN_vkCreateImageView vkCreateImageView;
+PFN_vkCreateSampler vkCreateSampler;
+PFN_vkCreateSamplerYcbcrConversion vkCreateSamplerYcbcrConversion;
 PFN_vkGetImageMemoryRequirements vkGetImageMemoryRequirements;
+PFN_vkGetImageMemoryRequirements2 vkGetImageMemoryRequirements2;
 PFN_vkAllocateMemory vkAllocateMemory;
 PFN_vkBindImageMemory vkBindImageMemory;
 PFN_vkCreateSemaphore vkCreateSemaphore;
+#if defined(_WIN32)
 PFN_vkImportSemaphoreWin32HandleKHR vkImportSemaphoreWin32HandleKHR;
+#else
+PFN_vkImportSemaphoreFdKHR vkImportSemaphoreFdKHR;
+PFN_vkGetMemoryFdPropertiesKHR vkGetMemoryFdPropertiesKHR;
+#endif
 PFN_vkFreeMemory vkFreeMemory;
 PFN_vkDestroyImage vkDestroyImage;
 PFN_vkDestroySemaphore vkDestroySemaphore;
+PFN_vkCreateBuffer vkCreateBuffer;
+PFN_vkGetBufferMemoryRequirements vkGetBufferMemoryRequirements;
+PFN_vkBindBufferMemory vkBindBufferMemory;
+PFN_vkDestroyBuffer vkDestroyBuffer;
+PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier;
+PFN_vkCmdResolveImage vkCmdResolveImage;
+PFN_vkCreateCommandPool vkCreateCommandPool;
+PFN_vkDestroyCommandPool vkDestroyCommandPool;
+PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
+PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
+PFN_vkEndCommandBuffer vkEndCommandBuffer;
+PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
+PFN_vkCmdCopyImage vkCmdCopyImage;
+PFN_vkCmdBlitImage vkCmdBlitImage;
+PFN_vkCmdPipelineBarrier2 vkCmdPipelineBarrier2;
 
 static VkFormat SharedTexture_ToVulkanFormat(shared_texture_format Format)
 {
@@ -210,62 +965,699 @@ static VkFormat SharedTexture_ToVulkanFormat(shared_texture_format Format)
     {
         case SHARED_TEXTURE_RGBA8: return VK_FORMAT_R8G8B8A8_UNORM;
         case SHARED_TEXTURE_DEPTH: return VK_FORMAT_D32_SFLOAT;
+        case SHARED_TEXTURE_RGBA8_SRGB: return VK_FORMAT_R8G8B8A8_SRGB;
+        case SHARED_TEXTURE_RGBA8_UINT: return VK_FORMAT_R8G8B8A8_UINT;
+        case SHARED_TEXTURE_NV12: return VK_FORMAT_G8_B8R8_2PLANE_420_UNORM;
+        case SHARED_TEXTURE_P010: return VK_FORMAT_G10X6_B10X6R10X6_2PLANE_420_UNORM_3PACK16;
+        case SHARED_TEXTURE_I420: return VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM;
+        case SHARED_TEXTURE_RGBA16F: return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case SHARED_TEXTURE_RGB10A2: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
     }
     return VK_FORMAT_UNDEFINED;
 }
 
-static vk_shared_texture SharedTexture_ToVulkan(shared_texture SharedTexture, VkDevice Device, VkPhysicalDevice PhysicalDevice)
+static VkImageViewType SharedTexture_ToVulkanImageViewType(shared_texture SharedTexture)
+{
+    switch (SharedTexture.Type)
+    {
+        case SHARED_TEXTURE_2D_ARRAY: return VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        case SHARED_TEXTURE_CUBE: return SharedTexture.Layers > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        case SHARED_TEXTURE_3D: return VK_IMAGE_VIEW_TYPE_3D;
+    }
+    return VK_IMAGE_VIEW_TYPE_2D;
+}
+
+static VkImageUsageFlags SharedTexture_ToVulkanImageUsage(shared_texture SharedTexture)
 {
-    VkFormat Format = SharedTexture_ToVulkanFormat(SharedTexture.Format);
+    VkImageUsageFlags Usage = 0;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_SAMPLED)
+        Usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_RENDER)
+        Usage |= SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_STORAGE)
+        Usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_TRANSFER_SRC)
+        Usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if (SharedTexture.Usage & SHARED_TEXTURE_USAGE_TRANSFER_DST)
+        Usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    return Usage;
+}
 
-    // IMAGE
-    VkImage Image;
-    VkExternalMemoryImageCreateInfo ExternalMemoryImageCreateInfo;
-    ExternalMemoryImageCreateInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO;
-    ExternalMemoryImageCreateInfo.pNext = 0;
-    ExternalMemoryImageCreateInfo.handleTypes = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE;
+// Producer and consumers must describe the image identically, otherwise the import is undefined.
+static VkImageCreateInfo SharedTexture_ToVulkanImageCreateInfo(shared_texture SharedTexture, const void *pNext)
+{
     VkImageCreateInfo ImageCreateInfo;
-    ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-    ImageCreateInfo.pNext = &ExternalMemoryImageCreateInfo;
-    ImageCreateInfo.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
-    ImageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-    ImageCreateInfo.format = Format;
+    ImageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ImageCreateInfo.pNext = pNext;
+    ImageCreateInfo.flags = 0;
+    if ((SharedTexture.Usage & SHARED_TEXTURE_USAGE_MUTABLE) || SharedTexture.ViewFormats)
+        ImageCreateInfo.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+    // Mutable dma-buf images need a view format list next to the modifier list.
+    if ((SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF) && !SharedTexture.ViewFormats)
+        ImageCreateInfo.flags = 0;
+    if (SharedTexture.Type == SHARED_TEXTURE_CUBE)
+        ImageCreateInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    ImageCreateInfo.imageType = SharedTexture.Type == SHARED_TEXTURE_3D ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+    ImageCreateInfo.format = SharedTexture_ToVulkanFormat(SharedTexture.Format);
     ImageCreateInfo.extent.width = SharedTexture.Width;
     ImageCreateInfo.extent.height = SharedTexture.Height;
-    ImageCreateInfo.extent.depth = 1;
+    ImageCreateInfo.extent.depth = SharedTexture.Depth;
     ImageCreateInfo.mipLevels = 1;
-    ImageCreateInfo.arrayLayers = 1;
-    ImageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    ImageCreateInfo.arrayLayers = SharedTexture.Layers;
+    ImageCreateInfo.samples = SharedTexture.Samples > 1 ? (VkSampleCountFlagBits)SharedTexture.Samples : VK_SAMPLE_COUNT_1_BIT;
     ImageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    ImageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | 
-                            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF)
+        ImageCreateInfo.tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT;
+    if ((SharedTexture.Flags & SHARED_TEXTURE_FLAG_HOST) || SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format))
+        ImageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
+    ImageCreateInfo.usage = SharedTexture_ToVulkanImageUsage(SharedTexture);
     ImageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     ImageCreateInfo.queueFamilyIndexCount = 0;
     ImageCreateInfo.pQueueFamilyIndices = 0;
     ImageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    return ImageCreateInfo;
+}
+
+static const void *SharedTexture_ToVulkanFormatList(shared_texture SharedTexture, vk_shared_format_list *FormatList, const void *pNext)
+{
+    if (!SharedTexture.ViewFormats)
+        return pNext;
+
+    uint32_t Count = 0;
+    FormatList->Formats[Count++] = SharedTexture_ToVulkanFormat((shared_texture_format)SharedTexture.Format);
+    for (uint32_t Format = 1; Format < 32 && Count < 8; ++Format)
+        if (Format != SharedTexture.Format && (SharedTexture.ViewFormats & SHARED_TEXTURE_FORMAT_BIT(Format)))
+            FormatList->Formats[Count++] = SharedTexture_ToVulkanFormat((shared_texture_format)Format);
+    FormatList->CreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_LIST_CREATE_INFO;
+    FormatList->CreateInfo.pNext = pNext;
+    FormatList->CreateInfo.viewFormatCount = Count;
+    FormatList->CreateInfo.pViewFormats = FormatList->Formats;
+    return &FormatList->CreateInfo;
+}
+
+// A view of the whole texture read as Format, which is the texture's own
+// format or one of its ViewFormats.
+static VkImageView SharedTexture_CreateVulkanView(vk_shared_texture VKSharedTexture, shared_texture SharedTexture, shared_texture_format Format, VkDevice Device)
+{
+    VkImageView View = VK_NULL_HANDLE;
+    if (Format != SharedTexture.Format && !(SharedTexture.ViewFormats & SHARED_TEXTURE_FORMAT_BIT(Format)))
+        return View;
+    if (SHARED_TEXTURE_IS_YCBCR(Format))
+        return View;
+
+    VkImageViewCreateInfo ImageViewCreateInfo;
+    ImageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    ImageViewCreateInfo.pNext = 0;
+    ImageViewCreateInfo.flags = 0;
+    ImageViewCreateInfo.image = VKSharedTexture.Image;
+    ImageViewCreateInfo.viewType = SharedTexture_ToVulkanImageViewType(SharedTexture);
+    ImageViewCreateInfo.format = SharedTexture_ToVulkanFormat(Format);
+    ImageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.subresourceRange.aspectMask = Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    ImageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+    ImageViewCreateInfo.subresourceRange.levelCount = 1;
+    ImageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    ImageViewCreateInfo.subresourceRange.layerCount = SharedTexture.Layers;
+    vkCreateImageView(Device, &ImageViewCreateInfo, 0, &View);
+    return View;
+}
+
+// YCbCr textures are sampled through a conversion, so the shader reads RGB
+// with no extra pass. The consumer device needs samplerYcbcrConversion enabled.
+static VkSamplerYcbcrConversion SharedTexture_CreateVulkanYcbcrConversion(shared_texture SharedTexture, VkDevice Device)
+{
+    VkSamplerYcbcrConversion Conversion = VK_NULL_HANDLE;
+    if (!SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format))
+        return Conversion;
+
+    VkSamplerYcbcrConversionCreateInfo ConversionCreateInfo;
+    ConversionCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_CREATE_INFO;
+    ConversionCreateInfo.pNext = 0;
+    ConversionCreateInfo.format = SharedTexture_ToVulkanFormat((shared_texture_format)SharedTexture.Format);
+    ConversionCreateInfo.ycbcrModel = SharedTexture.Primaries == SHARED_TEXTURE_PRIMARIES_BT2020 ?
+        VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_2020 : VK_SAMPLER_YCBCR_MODEL_CONVERSION_YCBCR_709;
+    ConversionCreateInfo.ycbcrRange = VK_SAMPLER_YCBCR_RANGE_ITU_NARROW;
+    ConversionCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ConversionCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ConversionCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ConversionCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ConversionCreateInfo.xChromaOffset = VK_CHROMA_LOCATION_COSITED_EVEN;
+    ConversionCreateInfo.yChromaOffset = VK_CHROMA_LOCATION_MIDPOINT;
+    ConversionCreateInfo.chromaFilter = VK_FILTER_LINEAR;
+    ConversionCreateInfo.forceExplicitReconstruction = VK_FALSE;
+    vkCreateSamplerYcbcrConversion(Device, &ConversionCreateInfo, 0, &Conversion);
+    return Conversion;
+}
+
+static VkImageView SharedTexture_CreateVulkanYcbcrView(vk_shared_texture VKSharedTexture, shared_texture SharedTexture, VkSamplerYcbcrConversion Conversion, VkDevice Device)
+{
+    VkImageView View = VK_NULL_HANDLE;
+    VkSamplerYcbcrConversionInfo ConversionInfo;
+    ConversionInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO;
+    ConversionInfo.pNext = 0;
+    ConversionInfo.conversion = Conversion;
+
+    VkImageViewCreateInfo ImageViewCreateInfo;
+    ImageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    ImageViewCreateInfo.pNext = &ConversionInfo;
+    ImageViewCreateInfo.flags = 0;
+    ImageViewCreateInfo.image = VKSharedTexture.Image;
+    ImageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    ImageViewCreateInfo.format = SharedTexture_ToVulkanFormat((shared_texture_format)SharedTexture.Format);
+    ImageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    ImageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ImageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+    ImageViewCreateInfo.subresourceRange.levelCount = 1;
+    ImageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    ImageViewCreateInfo.subresourceRange.layerCount = 1;
+    vkCreateImageView(Device, &ImageViewCreateInfo, 0, &View);
+    return View;
+}
+
+// Must be bound as an immutable sampler of the descriptor set layout.
+static VkSampler SharedTexture_CreateVulkanYcbcrSampler(VkSamplerYcbcrConversion Conversion, VkDevice Device)
+{
+    VkSampler Sampler = VK_NULL_HANDLE;
+    VkSamplerYcbcrConversionInfo ConversionInfo;
+    ConversionInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO;
+    ConversionInfo.pNext = 0;
+    ConversionInfo.conversion = Conversion;
+
+    VkSamplerCreateInfo SamplerCreateInfo;
+    SamplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    SamplerCreateInfo.pNext = &ConversionInfo;
+    SamplerCreateInfo.flags = 0;
+    SamplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+    SamplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+    SamplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    SamplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    SamplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    SamplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    SamplerCreateInfo.mipLodBias = 0.0f;
+    SamplerCreateInfo.anisotropyEnable = VK_FALSE;
+    SamplerCreateInfo.maxAnisotropy = 1.0f;
+    SamplerCreateInfo.compareEnable = VK_FALSE;
+    SamplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+    SamplerCreateInfo.minLod = 0.0f;
+    SamplerCreateInfo.maxLod = 0.0f;
+    SamplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    SamplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+    vkCreateSampler(Device, &SamplerCreateInfo, 0, &Sampler);
+    return Sampler;
+}
+
+// Swapchain color space that presents the texture without conversion, e.g. to
+// pass HDR10 straight to the display. VK_COLOR_SPACE_MAX_ENUM_KHR if none fits.
+static VkColorSpaceKHR SharedTexture_ToVulkanColorSpace(shared_texture SharedTexture)
+{
+    bool BT2020 = SharedTexture.Primaries == SHARED_TEXTURE_PRIMARIES_BT2020;
+    switch (SharedTexture.Transfer)
+    {
+        case SHARED_TEXTURE_TRANSFER_SRGB: return BT2020 ? VK_COLOR_SPACE_MAX_ENUM_KHR : VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+        case SHARED_TEXTURE_TRANSFER_LINEAR: return BT2020 ? VK_COLOR_SPACE_BT2020_LINEAR_EXT : VK_COLOR_SPACE_EXTENDED_SRGB_LINEAR_EXT;
+        case SHARED_TEXTURE_TRANSFER_PQ: return BT2020 ? VK_COLOR_SPACE_HDR10_ST2084_EXT : VK_COLOR_SPACE_MAX_ENUM_KHR;
+        case SHARED_TEXTURE_TRANSFER_HLG: return BT2020 ? VK_COLOR_SPACE_HDR10_HLG_EXT : VK_COLOR_SPACE_MAX_ENUM_KHR;
+    }
+    return VK_COLOR_SPACE_MAX_ENUM_KHR;
+}
+
+static VkImageLayout SharedTexture_ToVulkanLayout(shared_texture_layout Layout)
+{
+    switch (Layout)
+    {
+        case SHARED_TEXTURE_LAYOUT_UNDEFINED: return VK_IMAGE_LAYOUT_UNDEFINED;
+        case SHARED_TEXTURE_LAYOUT_GENERAL: return VK_IMAGE_LAYOUT_GENERAL;
+        case SHARED_TEXTURE_LAYOUT_COLOR_ATTACHMENT: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        case SHARED_TEXTURE_LAYOUT_DEPTH_ATTACHMENT: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        case SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY: return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        case SHARED_TEXTURE_LAYOUT_TRANSFER_SRC: return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        case SHARED_TEXTURE_LAYOUT_TRANSFER_DST: return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        default: break;
+    }
+    return VK_IMAGE_LAYOUT_GENERAL;
+}
+
+// Layouts GL has no enum for become SHARED_TEXTURE_LAYOUT_GENERAL.
+static shared_texture_layout SharedTexture_FromVulkanLayout(VkImageLayout Layout)
+{
+    switch (Layout)
+    {
+        case VK_IMAGE_LAYOUT_UNDEFINED: return SHARED_TEXTURE_LAYOUT_UNDEFINED;
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return SHARED_TEXTURE_LAYOUT_COLOR_ATTACHMENT;
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return SHARED_TEXTURE_LAYOUT_DEPTH_ATTACHMENT;
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY;
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return SHARED_TEXTURE_LAYOUT_TRANSFER_SRC;
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return SHARED_TEXTURE_LAYOUT_TRANSFER_DST;
+        default: break;
+    }
+    return SHARED_TEXTURE_LAYOUT_GENERAL;
+}
+
+// Layout the image is in once the texture's semaphore was waited on.
+static VkImageLayout SharedTexture_VulkanLayout(shared_texture SharedTexture)
+{
+    return SharedTexture_ToVulkanLayout(SharedTexture_SignalLayout(SharedTexture));
+}
+
+// Barrier taking the image over from the other processes after waiting on the
+// texture's semaphore, moving it from the layout they left it in to Layout.
+// Stages and access masks are left for the caller to narrow down.
+static VkImageMemoryBarrier SharedTexture_VulkanAcquire(shared_texture SharedTexture, vk_shared_texture VKSharedTexture, uint32_t QueueFamilyIndex, VkImageLayout Layout)
+{
+    VkImageMemoryBarrier Barrier;
+    Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    Barrier.pNext = 0;
+    Barrier.srcAccessMask = 0;
+    Barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    Barrier.oldLayout = SharedTexture_VulkanLayout(SharedTexture);
+    Barrier.newLayout = Layout;
+    Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    Barrier.dstQueueFamilyIndex = QueueFamilyIndex;
+    Barrier.image = VKSharedTexture.Image;
+    Barrier.subresourceRange.aspectMask = SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    Barrier.subresourceRange.baseMipLevel = 0;
+    Barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    Barrier.subresourceRange.baseArrayLayer = 0;
+    Barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    return Barrier;
+}
+
+// Barrier handing the image in Layout back before signalling the texture's
+// semaphore. Layouts GL cannot name are moved to VK_IMAGE_LAYOUT_GENERAL.
+// Record it into the submit that signals and, once that returned, publish the
+// barrier's newLayout with SharedTexture_StoreLayout.
+static VkImageMemoryBarrier SharedTexture_VulkanRelease(shared_texture SharedTexture, vk_shared_texture VKSharedTexture, uint32_t QueueFamilyIndex, VkImageLayout Layout)
+{
+    shared_texture_layout Shared = SharedTexture_FromVulkanLayout(Layout);
+    VkImageMemoryBarrier Barrier = SharedTexture_VulkanAcquire(SharedTexture, VKSharedTexture, QueueFamilyIndex, Layout);
+    Barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    Barrier.dstAccessMask = 0;
+    Barrier.oldLayout = Layout;
+    Barrier.newLayout = SharedTexture_ToVulkanLayout(Shared);
+    Barrier.srcQueueFamilyIndex = QueueFamilyIndex;
+    Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    return Barrier;
+}
+
+// Producer: records the resolve of the multisampled image into the ring slot
+// after the published one. Record it last into the command buffer whose submit
+// signals the texture's semaphore, so resolve and signal are one submission,
+// and pass the returned slot to SharedTexture_StoreSignal once that submit
+// returned. Image is expected in Layout and returned to it, the slot is left
+// in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+static uint32_t SharedTexture_VulkanRecordResolve(shared_texture *SharedTexture, vk_shared_texture VKSharedTexture, VkCommandBuffer CommandBuffer, VkImageLayout Layout)
+{
+    if (!SharedTexture->ResolveSlots || !VKSharedTexture.Resolve)
+        return 0;
+    uint32_t Slot = 0;
+    if (SharedTexture->Control)
+        Slot = (SharedTexture_ResolveSlot(*SharedTexture) + 1) % SharedTexture->ResolveSlots;
+
+    VkImageMemoryBarrier Barriers[2];
+    Barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    Barriers[0].pNext = 0;
+    Barriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    Barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    Barriers[0].oldLayout = Layout;
+    Barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    Barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    Barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    Barriers[0].image = VKSharedTexture.Image;
+    Barriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    Barriers[0].subresourceRange.baseMipLevel = 0;
+    Barriers[0].subresourceRange.levelCount = 1;
+    Barriers[0].subresourceRange.baseArrayLayer = 0;
+    Barriers[0].subresourceRange.layerCount = 1;
+    // The slot's previous contents are discarded.
+    Barriers[1] = Barriers[0];
+    Barriers[1].srcAccessMask = 0;
+    Barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    Barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    Barriers[1].image = VKSharedTexture.Resolve;
+    Barriers[1].subresourceRange.baseArrayLayer = Slot;
+    vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, 0, 0, 0, 2, Barriers);
+
+    VkImageResolve Region;
+    Region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    Region.srcSubresource.mipLevel = 0;
+    Region.srcSubresource.baseArrayLayer = 0;
+    Region.srcSubresource.layerCount = 1;
+    Region.srcOffset.x = 0;
+    Region.srcOffset.y = 0;
+    Region.srcOffset.z = 0;
+    Region.dstSubresource = Region.srcSubresource;
+    Region.dstSubresource.baseArrayLayer = Slot;
+    Region.dstOffset = Region.srcOffset;
+    Region.extent.width = SharedTexture->Width;
+    Region.extent.height = SharedTexture->Height;
+    Region.extent.depth = 1;
+    vkCmdResolveImage(CommandBuffer, VKSharedTexture.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VKSharedTexture.Resolve, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Region);
+
+    Barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    Barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    Barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    Barriers[0].newLayout = Layout;
+    Barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barriers[1].dstAccessMask = 0;
+    Barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    Barriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, 0, 0, 0, 2, Barriers);
+    return Slot;
+}
+
+// The device needs the synchronization2 feature.
+static bool SharedTexture_CreateVulkanCopy(vk_shared_copy *Copy, VkDevice Device, uint32_t QueueFamilyIndex)
+{
+    memset(Copy, 0, sizeof(vk_shared_copy));
+    Copy->Device = Device;
+    Copy->QueueFamilyIndex = QueueFamilyIndex;
+    Copy->Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkCommandPoolCreateInfo CommandPoolCreateInfo;
+    CommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    CommandPoolCreateInfo.pNext = 0;
+    CommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    CommandPoolCreateInfo.queueFamilyIndex = QueueFamilyIndex;
+    return vkCreateCommandPool(Device, &CommandPoolCreateInfo, 0, &Copy->CommandPool) == VK_SUCCESS;
+}
+
+// The command buffers must not be in flight anymore.
+static void SharedTexture_DestroyVulkanCopy(vk_shared_copy *Copy)
+{
+    if (Copy->CommandPool)
+        vkDestroyCommandPool(Copy->Device, Copy->CommandPool, 0);
+    memset(Copy, 0, sizeof(vk_shared_copy));
+}
+
+// Consumer: drops what was recorded for Image, or for every destination if
+// Image is VK_NULL_HANDLE. Call it once no submit of those copies is in flight
+// anymore and before destroying Image, e.g. with the swapchain, since a new
+// image may get the same handle value.
+static void SharedTexture_InvalidateVulkanCopy(vk_shared_copy *Copy, VkImage Image)
+{
+    for (uint32_t i = 0; i < Copy->TargetCount; ++i)
+        if (Image == VK_NULL_HANDLE || Copy->Targets[i].Image == Image)
+            Copy->Targets[i].Image = VK_NULL_HANDLE;
+}
+
+static void SharedTexture_RecordVulkanCopyTarget(vk_shared_copy *Copy, shared_texture SharedTexture, vk_shared_copy_target *Target)
+{
+    VkImageAspectFlags Aspect = SharedTexture.Format == SHARED_TEXTURE_DEPTH ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    bool Blit = Target->FlipY || Target->Format != SharedTexture_ToVulkanFormat((shared_texture_format)SharedTexture.Format) ||
+                Target->Width != SharedTexture.Width || Target->Height != SharedTexture.Height;
+
+    VkCommandBufferInheritanceInfo InheritanceInfo;
+    memset(&InheritanceInfo, 0, sizeof(InheritanceInfo));
+    InheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    VkCommandBufferBeginInfo CommandBufferBeginInfo;
+    CommandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    CommandBufferBeginInfo.pNext = 0;
+    CommandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    CommandBufferBeginInfo.pInheritanceInfo = &InheritanceInfo;
+    vkBeginCommandBuffer(Target->CommandBuffer, &CommandBufferBeginInfo);
+
+    // Both images are transitioned in one barrier, which also acquires the
+    // shared image from the other processes in the layout they left it in, so
+    // it keeps its contents. The semaphore waits of the submit are expected at
+    // VK_PIPELINE_STAGE_TRANSFER_BIT, which the barrier chains onto.
+    VkImageMemoryBarrier2 Barriers[2];
+    Barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    Barriers[0].pNext = 0;
+    Barriers[0].srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    Barriers[0].srcAccessMask = VK_ACCESS_2_NONE;
+    Barriers[0].dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    Barriers[0].dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+    Barriers[0].oldLayout = Target->AcquireLayout;
+    Barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    Barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    Barriers[0].dstQueueFamilyIndex = Copy->QueueFamilyIndex;
+    Barriers[0].image = Copy->Source;
+    Barriers[0].subresourceRange.aspectMask = Aspect;
+    Barriers[0].subresourceRange.baseMipLevel = 0;
+    Barriers[0].subresourceRange.levelCount = 1;
+    Barriers[0].subresourceRange.baseArrayLayer = 0;
+    Barriers[0].subresourceRange.layerCount = 1;
+    Barriers[1] = Barriers[0];
+    Barriers[1].dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    Barriers[1].oldLayout = Target->OldLayout;
+    Barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    Barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    Barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    Barriers[1].image = Target->Image;
+    VkDependencyInfo DependencyInfo;
+    memset(&DependencyInfo, 0, sizeof(DependencyInfo));
+    DependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    DependencyInfo.imageMemoryBarrierCount = 2;
+    DependencyInfo.pImageMemoryBarriers = Barriers;
+    vkCmdPipelineBarrier2(Target->CommandBuffer, &DependencyInfo);
+
+    VkImageSubresourceLayers Subresource;
+    Subresource.aspectMask = Aspect;
+    Subresource.mipLevel = 0;
+    Subresource.baseArrayLayer = 0;
+    Subresource.layerCount = 1;
+    if (Blit)
+    {
+        VkImageBlit Region;
+        Region.srcSubresource = Subresource;
+        Region.srcOffsets[0].x = 0;
+        Region.srcOffsets[0].y = Target->FlipY ? SharedTexture.Height : 0;
+        Region.srcOffsets[0].z = 0;
+        Region.srcOffsets[1].x = SharedTexture.Width;
+        Region.srcOffsets[1].y = Target->FlipY ? 0 : SharedTexture.Height;
+        Region.srcOffsets[1].z = 1;
+        Region.dstSubresource = Subresource;
+        Region.dstOffsets[0].x = 0;
+        Region.dstOffsets[0].y = 0;
+        Region.dstOffsets[0].z = 0;
+        Region.dstOffsets[1].x = Target->Width;
+        Region.dstOffsets[1].y = Target->Height;
+        Region.dstOffsets[1].z = 1;
+        vkCmdBlitImage(Target->CommandBuffer, Copy->Source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            Target->Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Region,
+            (Target->Width == SharedTexture.Width && Target->Height == SharedTexture.Height) || Aspect != VK_IMAGE_ASPECT_COLOR_BIT ?
+                VK_FILTER_NEAREST : VK_FILTER_LINEAR);
+    }
+    else
+    {
+        VkImageCopy Region;
+        Region.srcSubresource = Subresource;
+        Region.srcOffset.x = 0;
+        Region.srcOffset.y = 0;
+        Region.srcOffset.z = 0;
+        Region.dstSubresource = Subresource;
+        Region.dstOffset = Region.srcOffset;
+        Region.extent.width = SharedTexture.Width;
+        Region.extent.height = SharedTexture.Height;
+        Region.extent.depth = 1;
+        vkCmdCopyImage(Target->CommandBuffer, Copy->Source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            Target->Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Region);
+    }
+
+    // The shared image is released to the other processes, whatever follows
+    // in the same submit may use the destination.
+    Barriers[0].srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    Barriers[0].srcAccessMask = VK_ACCESS_2_NONE;
+    Barriers[0].dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    Barriers[0].dstAccessMask = VK_ACCESS_2_NONE;
+    Barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    Barriers[0].newLayout = Target->ReleaseLayout;
+    Barriers[0].srcQueueFamilyIndex = Copy->QueueFamilyIndex;
+    Barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+    Barriers[1].srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    Barriers[1].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    Barriers[1].dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    Barriers[1].dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+    Barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    Barriers[1].newLayout = Target->NewLayout;
+    vkCmdPipelineBarrier2(Target->CommandBuffer, &DependencyInfo);
+    vkEndCommandBuffer(Target->CommandBuffer);
+}
+
+// Consumer: records the copy of the shared texture into Image, which is in
+// OldLayout before and NewLayout after, between waiting on the texture's
+// semaphore and signalling it. Copies when formats and sizes match and blits
+// otherwise, FlipY turns the image upside down, e.g. for OpenGL producers.
+// The shared image is acquired in the layout the last signal left it in and
+// handed back in Copy->Layout, record the copy into the submit that signals and
+// publish SharedTexture_FromVulkanLayout(Copy->Layout) with
+// SharedTexture_StoreLayout once that returned. Returns false for textures
+// that cannot be copied, multisampled ones go through SharedTexture_ToResolve,
+// and when all SHARED_TEXTURE_MAX_COPY_TARGETS secondaries are in use, see
+// SharedTexture_InvalidateVulkanCopy.
+static bool SharedTexture_VulkanRecordCopy(vk_shared_copy *Copy, VkCommandBuffer CommandBuffer, shared_texture SharedTexture, vk_shared_texture VKSharedTexture,
+                                           VkImage Image, VkFormat Format, int32_t Width, int32_t Height, VkImageLayout OldLayout, VkImageLayout NewLayout, bool FlipY)
+{
+    if (SharedTexture.Type != SHARED_TEXTURE_2D || SharedTexture.Samples > 1 || SHARED_TEXTURE_IS_YCBCR(SharedTexture.Format) ||
+        !(SharedTexture.Usage & SHARED_TEXTURE_USAGE_TRANSFER_SRC) || !VKSharedTexture.Image)
+        return false;
+
+    VkImageLayout AcquireLayout = SharedTexture_VulkanLayout(SharedTexture);
+    shared_texture_layout Release = SharedTexture_FromVulkanLayout(Copy->Layout);
+    VkImageLayout ReleaseLayout = SharedTexture_ToVulkanLayout(Release);
+    vk_shared_copy_target *Target = 0;
+    for (uint32_t i = 0; i < Copy->TargetCount && !Target; ++i)
+    {
+        vk_shared_copy_target *Cached = &Copy->Targets[i];
+        if (Cached->Image == Image && Cached->Format == Format && Cached->Width == Width && Cached->Height == Height &&
+            Cached->OldLayout == OldLayout && Cached->NewLayout == NewLayout && Cached->FlipY == FlipY &&
+            Cached->AcquireLayout == AcquireLayout && Cached->ReleaseLayout == ReleaseLayout)
+            Target = Cached;
+    }
+
+    if (!Target)
+    {
+        // A new import re-records every destination, its old one is idle by now.
+        if (VKSharedTexture.Image != Copy->Source)
+        {
+            SharedTexture_InvalidateVulkanCopy(Copy, VK_NULL_HANDLE);
+            Copy->Source = VKSharedTexture.Image;
+        }
+        // Secondaries still in use are never reset, invalidated ones are
+        // re-recorded in place.
+        uint32_t Index = 0;
+        while (Index < Copy->TargetCount && Copy->Targets[Index].Image != VK_NULL_HANDLE)
+            Index++;
+        if (Index == SHARED_TEXTURE_MAX_COPY_TARGETS)
+            return false;
+        Target = &Copy->Targets[Index];
+        if (Index == Copy->TargetCount)
+        {
+            VkCommandBufferAllocateInfo CommandBufferAllocateInfo;
+            CommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            CommandBufferAllocateInfo.pNext = 0;
+            CommandBufferAllocateInfo.commandPool = Copy->CommandPool;
+            CommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            CommandBufferAllocateInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(Copy->Device, &CommandBufferAllocateInfo, &Target->CommandBuffer) != VK_SUCCESS)
+                return false;
+            Copy->TargetCount++;
+        }
+        Target->Image = Image;
+        Target->Format = Format;
+        Target->Width = Width;
+        Target->Height = Height;
+        Target->OldLayout = OldLayout;
+        Target->NewLayout = NewLayout;
+        Target->FlipY = FlipY;
+        Target->AcquireLayout = AcquireLayout;
+        Target->ReleaseLayout = ReleaseLayout;
+        SharedTexture_RecordVulkanCopyTarget(Copy, SharedTexture, Target);
+    }
+
+    vkCmdExecuteCommands(CommandBuffer, 1, &Target->CommandBuffer);
+    return true;
+}
+
+// Producer and consumers run the same search, so they agree on the memory type.
+static uint32_t SharedTexture_FindVulkanMemoryType(shared_texture SharedTexture, uint32_t MemoryTypeBits, VkPhysicalDevice PhysicalDevice)
+{
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_HOST)
+    {
+        int32_t Index = Vulkan_FindPhysicalDeviceMemoryIndex(PhysicalDevice, MemoryTypeBits,
+            (VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT));
+        if (Index < 0)
+            Index = Vulkan_FindPhysicalDeviceMemoryIndex(PhysicalDevice, MemoryTypeBits,
+                (VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+        return Index;
+    }
+    return Vulkan_FindPhysicalDeviceMemoryIndex(PhysicalDevice, MemoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+static VkExternalMemoryHandleTypeFlagBits SharedTexture_ToVulkanHandleType(shared_texture SharedTexture)
+{
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF)
+        return VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+    return VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE;
+}
+
+static VkImage SharedTexture_CreateVulkanImportImage(shared_texture SharedTexture, VkDevice Device)
+{
+    VkImage Image = VK_NULL_HANDLE;
+
+    // dma-buf images are recreated with exactly the layout the producer got.
+    VkSubresourceLayout PlaneLayouts[4];
+    for (uint32_t i = 0; i < SharedTexture.PlaneCount && i < 4; ++i)
+    {
+        PlaneLayouts[i].offset = SharedTexture.Planes[i].Offset;
+        PlaneLayouts[i].size = 0;
+        PlaneLayouts[i].rowPitch = SharedTexture.Planes[i].RowPitch;
+        PlaneLayouts[i].arrayPitch = 0;
+        PlaneLayouts[i].depthPitch = 0;
+    }
+    VkImageDrmFormatModifierExplicitCreateInfoEXT ImageDrmFormatModifierExplicitCreateInfo;
+    ImageDrmFormatModifierExplicitCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_EXPLICIT_CREATE_INFO_EXT;
+    ImageDrmFormatModifierExplicitCreateInfo.pNext = 0;
+    ImageDrmFormatModifierExplicitCreateInfo.drmFormatModifier = SharedTexture.Modifier;
+    ImageDrmFormatModifierExplicitCreateInfo.drmFormatModifierPlaneCount = SharedTexture.PlaneCount;
+    ImageDrmFormatModifierExplicitCreateInfo.pPlaneLayouts = PlaneLayouts;
+
+    VkExternalMemoryImageCreateInfo ExternalMemoryImageCreateInfo;
+    ExternalMemoryImageCreateInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO;
+    ExternalMemoryImageCreateInfo.pNext = (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DMA_BUF) ? &ImageDrmFormatModifierExplicitCreateInfo : 0;
+    ExternalMemoryImageCreateInfo.handleTypes = SharedTexture_ToVulkanHandleType(SharedTexture);
+    vk_shared_format_list FormatList;
+    VkImageCreateInfo ImageCreateInfo = SharedTexture_ToVulkanImageCreateInfo(SharedTexture,
+        SharedTexture_ToVulkanFormatList(SharedTexture, &FormatList, &ExternalMemoryImageCreateInfo));
     vkCreateImage(Device, &ImageCreateInfo, 0, &Image);
+    return Image;
+}
 
-    // MEMORY
-    VkDeviceMemory Memory;
-    VkMemoryRequirements MemReqs;
-    vkGetImageMemoryRequirements(Device, Image, &MemReqs);
-    uint32_t MemoryTypeIndex = Vulkan_FindPhysicalDeviceMemoryIndex(PhysicalDevice,
-        MemReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+// Memory exported as a dedicated allocation must be imported for the same image.
+static VkDeviceMemory SharedTexture_ImportVulkanMemory(shared_handle Handle, VkExternalMemoryHandleTypeFlagBits HandleType,
+                                                       VkDeviceSize Size, uint32_t MemoryTypeIndex, VkImage DedicatedImage, VkDevice Device)
+{
+    VkDeviceMemory Memory = VK_NULL_HANDLE;
+    VkMemoryDedicatedAllocateInfo MemoryDedicatedAllocateInfo;
+    MemoryDedicatedAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    MemoryDedicatedAllocateInfo.pNext = 0;
+    MemoryDedicatedAllocateInfo.image = DedicatedImage;
+    MemoryDedicatedAllocateInfo.buffer = VK_NULL_HANDLE;
+#if defined(_WIN32)
     VkImportMemoryWin32HandleInfoKHR ImportMemoryWin32HandleInfoKHR;
     ImportMemoryWin32HandleInfoKHR.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR;
-    ImportMemoryWin32HandleInfoKHR.pNext = 0;
-    ImportMemoryWin32HandleInfoKHR.handleType = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE;
-    ImportMemoryWin32HandleInfoKHR.handle = SharedTexture.Win32.MemoryHandle;
+    ImportMemoryWin32HandleInfoKHR.pNext = DedicatedImage != VK_NULL_HANDLE ? &MemoryDedicatedAllocateInfo : 0;
+    ImportMemoryWin32HandleInfoKHR.handleType = HandleType;
+    ImportMemoryWin32HandleInfoKHR.handle = Handle;
     ImportMemoryWin32HandleInfoKHR.name = 0;
     VkMemoryAllocateInfo MemoryAllocateInfo;
     MemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     MemoryAllocateInfo.pNext = &ImportMemoryWin32HandleInfoKHR;
-    MemoryAllocateInfo.allocationSize = MemReqs.size;
+#else
+    // A successful import takes ownership of the descriptor, so hand over a copy.
+    VkImportMemoryFdInfoKHR ImportMemoryFdInfoKHR;
+    ImportMemoryFdInfoKHR.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR;
+    ImportMemoryFdInfoKHR.pNext = DedicatedImage != VK_NULL_HANDLE ? &MemoryDedicatedAllocateInfo : 0;
+    ImportMemoryFdInfoKHR.handleType = HandleType;
+    ImportMemoryFdInfoKHR.fd = dup(Handle);
+    VkMemoryAllocateInfo MemoryAllocateInfo;
+    MemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    MemoryAllocateInfo.pNext = &ImportMemoryFdInfoKHR;
+#endif
+    MemoryAllocateInfo.allocationSize = Size;
     MemoryAllocateInfo.memoryTypeIndex = MemoryTypeIndex;
-    vkAllocateMemory(Device, &MemoryAllocateInfo, 0, &Memory);
-    vkBindImageMemory(Device, Image, Memory, 0);
-    
-    // SEMAPHORE
+    if (vkAllocateMemory(Device, &MemoryAllocateInfo, 0, &Memory) != VK_SUCCESS)
+    {
+#if !defined(_WIN32)
+        close(ImportMemoryFdInfoKHR.fd);
+#endif
+        return VK_NULL_HANDLE;
+    }
+    return Memory;
+}
+
+static VkSemaphore SharedTexture_ImportVulkanSemaphore(shared_handle Handle, VkDevice Device)
+{
     VkSemaphore Semaphore;
     VkSemaphoreCreateInfo SemaphoreCreateInfo;
     SemaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -280,17 +1672,146 @@ static vk_shared_texture SharedTexture_ToVulkan(shared_texture SharedTexture, Vk
     ImportSemaphoreWin32HandleInfoKHR.semaphore = Semaphore;
     ImportSemaphoreWin32HandleInfoKHR.flags = 0;
     ImportSemaphoreWin32HandleInfoKHR.handleType = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE;
-    ImportSemaphoreWin32HandleInfoKHR.handle = SharedTexture.Win32.SemaphoreHandle;
+    ImportSemaphoreWin32HandleInfoKHR.handle = Handle;
     ImportSemaphoreWin32HandleInfoKHR.name = 0;
     VkResult Result = vkImportSemaphoreWin32HandleKHR(Device, &ImportSemaphoreWin32HandleInfoKHR);
 #else
-  #error TODO Implement Posix
+    VkImportSemaphoreFdInfoKHR ImportSemaphoreFdInfoKHR;
+    ImportSemaphoreFdInfoKHR.sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR;
+    ImportSemaphoreFdInfoKHR.pNext = 0;
+    ImportSemaphoreFdInfoKHR.semaphore = Semaphore;
+    ImportSemaphoreFdInfoKHR.flags = 0;
+    ImportSemaphoreFdInfoKHR.handleType = VULKAN_EXTERNAL_SEMAPHORE_HANDLE_TYPE;
+    ImportSemaphoreFdInfoKHR.fd = dup(Handle);
+    VkResult Result = vkImportSemaphoreFdKHR(Device, &ImportSemaphoreFdInfoKHR);
+    if (Result != VK_SUCCESS)
+        close(ImportSemaphoreFdInfoKHR.fd);
+#endif
+    return Semaphore;
+}
+
+static vk_shared_texture SharedTexture_ToVulkan(shared_texture SharedTexture, VkDevice Device, VkPhysicalDevice PhysicalDevice)
+{
+    if (SharedTexture.Flags & SHARED_TEXTURE_FLAG_CPU)
+    {
+        vk_shared_texture None = { 0 };
+        return None;
+    }
+
+    // IMAGE
+    VkImage Image = SharedTexture_CreateVulkanImportImage(SharedTexture, Device);
+    VkImage Resolve = VK_NULL_HANDLE;
+    shared_texture ResolveTexture = SharedTexture_ToResolve(SharedTexture);
+    if (SharedTexture.ResolveSlots)
+        Resolve = SharedTexture_CreateVulkanImportImage(ResolveTexture, Device);
+
+    // MEMORY
+    VkMemoryRequirements MemReqs;
+    vkGetImageMemoryRequirements(Device, Image, &MemReqs);
+    if (Resolve)
+    {
+        VkMemoryRequirements ResolveMemReqs;
+        vkGetImageMemoryRequirements(Device, Resolve, &ResolveMemReqs);
+        MemReqs.memoryTypeBits &= ResolveMemReqs.memoryTypeBits;
+    }
+    VkExternalMemoryHandleTypeFlagBits HandleType = SharedTexture_ToVulkanHandleType(SharedTexture);
+#if !defined(_WIN32)
+    // A dma-buf may come from another driver, only the types it reports can import it.
+    if (HandleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT)
+    {
+        VkMemoryFdPropertiesKHR MemoryFdProperties;
+        MemoryFdProperties.sType = VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR;
+        MemoryFdProperties.pNext = 0;
+        MemoryFdProperties.memoryTypeBits = 0;
+        vkGetMemoryFdPropertiesKHR(Device, HandleType, SHARED_HANDLE(SharedTexture, MemoryHandle), &MemoryFdProperties);
+        MemReqs.memoryTypeBits &= MemoryFdProperties.memoryTypeBits;
+    }
 #endif
+    uint32_t MemoryTypeIndex = SharedTexture_FindVulkanMemoryType(SharedTexture, MemReqs.memoryTypeBits, PhysicalDevice);
+    VkImage DedicatedImage = (SharedTexture.Flags & SHARED_TEXTURE_FLAG_DEDICATED) ? Image : VK_NULL_HANDLE;
+    VkDeviceMemory Memory = SharedTexture_ImportVulkanMemory(SHARED_HANDLE(SharedTexture, MemoryHandle), HandleType,
+        SharedTexture.Size, MemoryTypeIndex, DedicatedImage, Device);
+    vkBindImageMemory(Device, Image, Memory, 0);
+    if (Resolve)
+        vkBindImageMemory(Device, Resolve, Memory, ResolveTexture.Offset);
+    
+    // SEMAPHORE
+    VkSemaphore Semaphore = SharedTexture_ImportVulkanSemaphore(SHARED_HANDLE(SharedTexture, SemaphoreHandle), Device);
 
     vk_shared_texture VKSharedTexture;
     VKSharedTexture.Image = Image;
     VKSharedTexture.Memory = Memory;
     VKSharedTexture.Semaphore = Semaphore;
+    VKSharedTexture.Resolve = Resolve;
+    return VKSharedTexture;
+}
+
+static VkMemoryRequirements SharedTexture_GetVulkanMemoryRequirements(VkImage Image, VkDevice Device, bool *Dedicated, bool *Required)
+{
+    VkMemoryDedicatedRequirements MemoryDedicatedRequirements;
+    MemoryDedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    MemoryDedicatedRequirements.pNext = 0;
+    VkMemoryRequirements2 MemoryRequirements2;
+    MemoryRequirements2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    MemoryRequirements2.pNext = &MemoryDedicatedRequirements;
+    VkImageMemoryRequirementsInfo2 ImageMemoryRequirementsInfo2;
+    ImageMemoryRequirementsInfo2.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    ImageMemoryRequirementsInfo2.pNext = 0;
+    ImageMemoryRequirementsInfo2.image = Image;
+    vkGetImageMemoryRequirements2(Device, &ImageMemoryRequirementsInfo2, &MemoryRequirements2);
+
+    if (Dedicated)
+        *Dedicated = MemoryDedicatedRequirements.prefersDedicatedAllocation || MemoryDedicatedRequirements.requiresDedicatedAllocation;
+    if (Required)
+        *Required = MemoryDedicatedRequirements.requiresDedicatedAllocation;
+    return MemoryRequirements2.memoryRequirements;
+}
+
+// Heaps are allocated from the memory type of a small probe image, which every
+// sub-allocated texture must also accept.
+static uint32_t SharedTextureHeap_FindVulkanMemoryType(VkDevice Device, VkPhysicalDevice PhysicalDevice)
+{
+    shared_texture Probe = { 0 };
+    Probe.Format = SHARED_TEXTURE_RGBA8;
+    Probe.Width = 1;
+    Probe.Height = 1;
+    Probe.Type = SHARED_TEXTURE_2D;
+    Probe.Depth = 1;
+    Probe.Layers = 1;
+    Probe.Usage = SHARED_TEXTURE_USAGE_DEFAULT;
+    VkImage Image = SharedTexture_CreateVulkanImportImage(Probe, Device);
+    if (Image == VK_NULL_HANDLE)
+        return UINT32_MAX;
+
+    VkMemoryRequirements MemReqs;
+    vkGetImageMemoryRequirements(Device, Image, &MemReqs);
+    vkDestroyImage(Device, Image, 0);
+    return Vulkan_FindPhysicalDeviceMemoryIndex(PhysicalDevice,
+        MemReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+static vk_shared_heap SharedTextureHeap_ToVulkan(shared_texture_heap Heap, VkDevice Device, VkPhysicalDevice PhysicalDevice)
+{
+    vk_shared_heap VKSharedHeap;
+    VKSharedHeap.Memory = VK_NULL_HANDLE;
+
+    uint32_t MemoryTypeIndex = SharedTextureHeap_FindVulkanMemoryType(Device, PhysicalDevice);
+    if (MemoryTypeIndex != UINT32_MAX)
+        VKSharedHeap.Memory = SharedTexture_ImportVulkanMemory(SHARED_HANDLE(Heap, MemoryHandle), VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE, Heap.Size, MemoryTypeIndex, VK_NULL_HANDLE, Device);
+    return VKSharedHeap;
+}
+
+// The texture borrows the heap's memory, destroy the heap after all its textures.
+static vk_shared_texture SharedTexture_ToVulkanInHeap(shared_texture SharedTexture, vk_shared_heap Heap, VkDevice Device)
+{
+    VkImage Image = SharedTexture_CreateVulkanImportImage(SharedTexture, Device);
+    vkBindImageMemory(Device, Image, Heap.Memory, SharedTexture.Offset);
+
+    vk_shared_texture VKSharedTexture;
+    VKSharedTexture.Image = Image;
+    VKSharedTexture.Memory = VK_NULL_HANDLE;
+    VKSharedTexture.Semaphore = SharedTexture_ImportVulkanSemaphore(SHARED_HANDLE(SharedTexture, SemaphoreHandle), Device);
+    VKSharedTexture.Resolve = VK_NULL_HANDLE;
     return VKSharedTexture;
 }
 
@@ -302,8 +1823,72 @@ static void SharedTexture_DestroyVulkanTexture(vk_shared_texture VKSharedTexture
     if (VKSharedTexture.Image)
         vkDestroyImage(Device, VKSharedTexture.Image, 0);
 
+    if (VKSharedTexture.Resolve)
+        vkDestroyImage(Device, VKSharedTexture.Resolve, 0);
+
     if (VKSharedTexture.Semaphore)
         vkDestroySemaphore(Device, VKSharedTexture.Semaphore, 0);
 }
 
+static void SharedTextureHeap_DestroyVulkanHeap(vk_shared_heap VKSharedHeap, VkDevice Device)
+{
+    if (VKSharedHeap.Memory)
+        vkFreeMemory(Device, VKSharedHeap.Memory, 0);
+}
+
+// Shared buffers are created with every usage a vertex, index, uniform or storage consumer may need.
+static VkBufferCreateInfo SharedBuffer_ToVulkanBufferCreateInfo(uint64_t Size, const void *pNext)
+{
+    VkBufferCreateInfo BufferCreateInfo;
+    BufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    BufferCreateInfo.pNext = pNext;
+    BufferCreateInfo.flags = 0;
+    BufferCreateInfo.size = Size;
+    BufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    BufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    BufferCreateInfo.queueFamilyIndexCount = 0;
+    BufferCreateInfo.pQueueFamilyIndices = 0;
+    return BufferCreateInfo;
+}
+
+static vk_shared_buffer SharedBuffer_ToVulkan(shared_buffer SharedBuffer, VkDevice Device, VkPhysicalDevice PhysicalDevice)
+{
+    // BUFFER
+    VkBuffer Buffer = VK_NULL_HANDLE;
+    VkExternalMemoryBufferCreateInfo ExternalMemoryBufferCreateInfo;
+    ExternalMemoryBufferCreateInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    ExternalMemoryBufferCreateInfo.pNext = 0;
+    ExternalMemoryBufferCreateInfo.handleTypes = VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE;
+    VkBufferCreateInfo BufferCreateInfo = SharedBuffer_ToVulkanBufferCreateInfo(SharedBuffer.Size, &ExternalMemoryBufferCreateInfo);
+    vkCreateBuffer(Device, &BufferCreateInfo, 0, &Buffer);
+
+    // MEMORY
+    VkMemoryRequirements MemReqs;
+    vkGetBufferMemoryRequirements(Device, Buffer, &MemReqs);
+    uint32_t MemoryTypeIndex = Vulkan_FindPhysicalDeviceMemoryIndex(PhysicalDevice,
+        MemReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkDeviceMemory Memory = SharedTexture_ImportVulkanMemory(SHARED_HANDLE(SharedBuffer, MemoryHandle), VULKAN_EXTERNAL_MEMORY_HANDLE_TYPE, SharedBuffer.MemorySize, MemoryTypeIndex, VK_NULL_HANDLE, Device);
+    vkBindBufferMemory(Device, Buffer, Memory, 0);
+
+    vk_shared_buffer VKSharedBuffer;
+    VKSharedBuffer.Buffer = Buffer;
+    VKSharedBuffer.Memory = Memory;
+    VKSharedBuffer.Semaphore = SharedTexture_ImportVulkanSemaphore(SHARED_HANDLE(SharedBuffer, SemaphoreHandle), Device);
+    return VKSharedBuffer;
+}
+
+static void SharedBuffer_DestroyVulkanBuffer(vk_shared_buffer VKSharedBuffer, VkDevice Device)
+{
+    if (VKSharedBuffer.Memory)
+        vkFreeMemory(Device, VKSharedBuffer.Memory, 0);
+
+    if (VKSharedBuffer.Buffer)
+        vkDestroyBuffer(Device, VKSharedBuffer.Buffer, 0);
+
+    if (VKSharedBuffer.Semaphore)
+        vkDestroySemaphore(Device, VKSharedBuffer.Semaphore, 0);
+}
+
 #endif // defined(SHARED_TEXTURE_VULKAN)
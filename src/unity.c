@@ -11,8 +11,69 @@ static IUnityInterfaces* UnityInterfaces = NULL;
 static IUnityGraphics* UnityGraphics = NULL;
 static IUnityGraphicsVulkanV2 *UnityVulkan = NULL;
 
+// Unity samples the textures, so every submit acquires them from the other
+// processes into VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and releases them in
+// it again. The acquire depends on the layout the last signal left, one is
+// recorded for each layout on first use.
+typedef struct unity_texture
+{
+    shared_texture SharedTexture;
+    vk_shared_texture Vulkan;
+    VkCommandBuffer Acquire[SHARED_TEXTURE_LAYOUT_COUNT];
+    VkCommandBuffer Release;
+} unity_texture;
+
 static uint32_t GlobalSharedTextureCount = 0;
-static vk_shared_texture **GlobalSharedTextures = NULL;
+static unity_texture **GlobalSharedTextures = NULL;
+static VkCommandPool GlobalCommandPool = VK_NULL_HANDLE;
+// Commands of Unity's device, loaded when the hook creates it.
+static vk_device_funcs UnityFuncs;
+// The library submits from any thread, so it gets a queue of its own next to
+// Unity's on the graphics family. UINT32_MAX if the family had none to spare.
+static uint32_t GlobalLibraryQueueFamilyIndex = UINT32_MAX;
+static uint32_t GlobalLibraryQueueIndex = 0;
+
+static VkCommandBuffer UnityHook_RecordBarrier(VkImageMemoryBarrier Barrier, VkPipelineStageFlags SrcStage, VkPipelineStageFlags DstStage)
+{
+    UnityVulkanInstance Instance = UnityVulkan->Instance();
+    VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+    VkResult Result = UnityFuncs.vkAllocateCommandBuffers(Instance.device,
+        &(VkCommandBufferAllocateInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = GlobalCommandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        },
+        &CommandBuffer
+    );
+    if (Result != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    UnityFuncs.vkBeginCommandBuffer(CommandBuffer,
+        &(VkCommandBufferBeginInfo) {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
+        }
+    );
+    UnityFuncs.vkCmdPipelineBarrier(CommandBuffer, SrcStage, DstStage, 0, 0, 0, 0, 0, 1, &Barrier);
+    UnityFuncs.vkEndCommandBuffer(CommandBuffer);
+    return CommandBuffer;
+}
+
+static VkCommandBuffer UnityHook_Acquire(unity_texture *Texture)
+{
+    shared_texture_layout Layout = SharedTexture_SignalLayout(Texture->SharedTexture);
+    if (!Texture->Acquire[Layout])
+    {
+        UnityVulkanInstance Instance = UnityVulkan->Instance();
+        VkImageMemoryBarrier Barrier = SharedTexture_VulkanAcquire(Texture->SharedTexture, Texture->Vulkan, Instance.queueFamilyIndex,
+                                                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        Barrier.oldLayout = SharedTexture_ToVulkanLayout(Layout);
+        Barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        // Chains onto the semaphore wait at VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT.
+        Texture->Acquire[Layout] = UnityHook_RecordBarrier(Barrier, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+    return Texture->Acquire[Layout];
+}
 
 static VkResult UnityHook_VkQueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *pSubmits, VkFence fence)
 {
@@ -22,34 +83,47 @@ static VkResult UnityHook_VkQueueSubmit(VkQueue queue, uint32_t submitCount, con
         SubmitInfos[i] = pSubmits[i];
         SubmitInfos[i].waitSemaphoreCount = pSubmits[i].waitSemaphoreCount + GlobalSharedTextureCount;
         SubmitInfos[i].signalSemaphoreCount = pSubmits[i].signalSemaphoreCount + GlobalSharedTextureCount;
+        SubmitInfos[i].commandBufferCount = pSubmits[i].commandBufferCount + 2 * GlobalSharedTextureCount;
 
         VkSemaphore *WaitSemaphores = malloc(sizeof(VkSemaphore) * SubmitInfos[i].waitSemaphoreCount);
         VkPipelineStageFlags *WaitDstStageMask = malloc(sizeof(VkPipelineStageFlags) * SubmitInfos[i].waitSemaphoreCount);
         VkSemaphore *SignalSemaphores = malloc(sizeof(VkSemaphore) * SubmitInfos[i].signalSemaphoreCount);
+        VkCommandBuffer *CommandBuffers = malloc(sizeof(VkCommandBuffer) * SubmitInfos[i].commandBufferCount);
 
         memcpy(WaitSemaphores, pSubmits[i].pWaitSemaphores, sizeof(VkSemaphore) * pSubmits[i].waitSemaphoreCount);
         memcpy(WaitDstStageMask, pSubmits[i].pWaitDstStageMask, sizeof(VkPipelineStageFlags) * pSubmits[i].waitSemaphoreCount);
         memcpy(SignalSemaphores, pSubmits[i].pSignalSemaphores, sizeof(VkSemaphore) * pSubmits[i].signalSemaphoreCount);
+        memcpy(CommandBuffers + GlobalSharedTextureCount, pSubmits[i].pCommandBuffers, sizeof(VkCommandBuffer) * pSubmits[i].commandBufferCount);
 
+        // Acquires go first and releases last, so Unity's own commands see the
+        // textures in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
         for (uint32_t j = 0; j < GlobalSharedTextureCount; ++j)
         {
-            WaitSemaphores[pSubmits[i].waitSemaphoreCount + j] = GlobalSharedTextures[j]->Semaphore;
+            unity_texture *Texture = GlobalSharedTextures[j];
+            WaitSemaphores[pSubmits[i].waitSemaphoreCount + j] = Texture->Vulkan.Semaphore;
             WaitDstStageMask[pSubmits[i].waitSemaphoreCount + j] = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-            SignalSemaphores[pSubmits[i].signalSemaphoreCount + j] = GlobalSharedTextures[j]->Semaphore;
+            SignalSemaphores[pSubmits[i].signalSemaphoreCount + j] = Texture->Vulkan.Semaphore;
+            CommandBuffers[j] = UnityHook_Acquire(Texture);
+            CommandBuffers[GlobalSharedTextureCount + pSubmits[i].commandBufferCount + j] = Texture->Release;
         }
 
         SubmitInfos[i].pWaitSemaphores = WaitSemaphores;
         SubmitInfos[i].pWaitDstStageMask = WaitDstStageMask;
         SubmitInfos[i].pSignalSemaphores = SignalSemaphores;
+        SubmitInfos[i].pCommandBuffers = CommandBuffers;
     }
 
-    VkResult Result = vkQueueSubmit(queue, submitCount, SubmitInfos, fence);
+    VkResult Result = UnityFuncs.vkQueueSubmit(queue, submitCount, SubmitInfos, fence);
+    if (Result == VK_SUCCESS && submitCount)
+        for (uint32_t j = 0; j < GlobalSharedTextureCount; ++j)
+            SharedTexture_StoreLayout(GlobalSharedTextures[j]->SharedTexture, SHARED_TEXTURE_LAYOUT_SHADER_READ_ONLY);
 
     for (uint32_t i = 0; i < submitCount; ++i)
     {
         free((void *)SubmitInfos[i].pWaitSemaphores);
         free((void *)SubmitInfos[i].pWaitDstStageMask);
         free((void *)SubmitInfos[i].pSignalSemaphores);
+        free((void *)SubmitInfos[i].pCommandBuffers);
     }
 
     free(SubmitInfos);
@@ -103,10 +177,43 @@ static VkResult UnityHook_vkCreateDevice(VkPhysicalDevice physicalDevice, const
     for (uint32_t i = 0; i < AdditionalExtCount; ++i)
         AllExtNames[pCreateInfo->enabledExtensionCount + i] = AdditionalExtNames[i];
 
+    uint32_t FamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &FamilyCount, 0);
+    VkQueueFamilyProperties *Families = malloc(sizeof(VkQueueFamilyProperties) * FamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &FamilyCount, Families);
+
+    // One more queue on the first graphics family Unity asks for.
+    VkDeviceQueueCreateInfo *QueueInfos = malloc(sizeof(VkDeviceQueueCreateInfo) * pCreateInfo->queueCreateInfoCount);
+    float *Priorities = NULL;
+    GlobalLibraryQueueFamilyIndex = UINT32_MAX;
+    for (uint32_t i = 0; i < pCreateInfo->queueCreateInfoCount; ++i)
+    {
+        QueueInfos[i] = pCreateInfo->pQueueCreateInfos[i];
+        uint32_t Family = QueueInfos[i].queueFamilyIndex;
+        if (GlobalLibraryQueueFamilyIndex != UINT32_MAX || Family >= FamilyCount ||
+            !(Families[Family].queueFlags & VK_QUEUE_GRAPHICS_BIT) || QueueInfos[i].queueCount >= Families[Family].queueCount)
+            continue;
+        Priorities = malloc(sizeof(float) * (QueueInfos[i].queueCount + 1));
+        for (uint32_t j = 0; j < QueueInfos[i].queueCount; ++j)
+            Priorities[j] = QueueInfos[i].pQueuePriorities[j];
+        Priorities[QueueInfos[i].queueCount] = 0.0f;
+        GlobalLibraryQueueFamilyIndex = Family;
+        GlobalLibraryQueueIndex = QueueInfos[i].queueCount++;
+        QueueInfos[i].pQueuePriorities = Priorities;
+    }
+
     VkDeviceCreateInfo CreateInfo = *pCreateInfo;
     CreateInfo.enabledExtensionCount = AllExtCount;
     CreateInfo.ppEnabledExtensionNames = AllExtNames;
+    CreateInfo.pQueueCreateInfos = QueueInfos;
     VkResult Result = vkCreateDevice(physicalDevice, &CreateInfo, pAllocator, pDevice);
+    if (Result == VK_SUCCESS)
+        VK_LoadDeviceFunctions(&UnityFuncs, vkGetDeviceProcAddr, *pDevice);
+    else
+        GlobalLibraryQueueFamilyIndex = UINT32_MAX;
+    free(Priorities);
+    free(QueueInfos);
+    free(Families);
     free((void *)AllExtNames);
     return Result;
 }
@@ -129,10 +236,35 @@ static PFN_vkGetInstanceProcAddr UNITY_INTERFACE_API Unity_VulkanInitCallback(PF
     return UnityHook_getInstanceProcAddr;
 }
 
+static void UnityHook_DestroyTexture(unity_texture *Texture)
+{
+    UnityVulkanInstance Instance = UnityVulkan->Instance();
+    UnityFuncs.vkDeviceWaitIdle(Instance.device);
+    for (uint32_t i = 0; i < SHARED_TEXTURE_LAYOUT_COUNT; ++i)
+        if (Texture->Acquire[i])
+            UnityFuncs.vkFreeCommandBuffers(Instance.device, GlobalCommandPool, 1, &Texture->Acquire[i]);
+    if (Texture->Release)
+        UnityFuncs.vkFreeCommandBuffers(Instance.device, GlobalCommandPool, 1, &Texture->Release);
+    SharedTexture_DestroyVulkanTexture(Texture->Vulkan, Instance.device);
+    SharedTexture_Close(Texture->SharedTexture);
+    free(Texture);
+}
+
 static void UNITY_INTERFACE_API Unity_OnGraphicsDeviceEvent(UnityGfxDeviceEventType EventType)
 {
-    if (EventType == kUnityGfxDeviceEventInitialize)
+    // Textures are created on Unity's device rather than a second one. Unity's
+    // graphics queue is never handed over, it is not synchronized with the
+    // library's submits; without a queue of its own the library does not submit.
+    if (EventType == kUnityGfxDeviceEventInitialize && UnityGraphics->GetRenderer() == kUnityGfxRendererVulkan)
     {
+        UnityVulkanInstance Instance = UnityVulkan->Instance();
+        if (SharedTexture_InitWithDevice(Instance.instance, Instance.physicalDevice, Instance.device, vkGetInstanceProcAddr) &&
+            GlobalLibraryQueueFamilyIndex != UINT32_MAX)
+        {
+            VkQueue Queue = VK_NULL_HANDLE;
+            UnityFuncs.vkGetDeviceQueue(Instance.device, GlobalLibraryQueueFamilyIndex, GlobalLibraryQueueIndex, &Queue);
+            SharedTexture_SetDeviceQueue(Queue, GlobalLibraryQueueFamilyIndex);
+        }
     }
 
     if (EventType == kUnityGfxDeviceEventShutdown)
@@ -142,20 +274,19 @@ static void UNITY_INTERFACE_API Unity_OnGraphicsDeviceEvent(UnityGfxDeviceEventT
             UnityVulkanInstance Instance = UnityVulkan->Instance();
 
             for (uint32_t i = 0; i < GlobalSharedTextureCount; ++i)
-            {
-                SharedTexture_DestroyVulkanTexture(*GlobalSharedTextures[i], Instance.device);
-                free(GlobalSharedTextures[i]);
-            }
+                UnityHook_DestroyTexture(GlobalSharedTextures[i]);
             free(GlobalSharedTextures);
             GlobalSharedTextureCount = 0;
             GlobalSharedTextures = NULL;
+            UnityFuncs.vkDestroyCommandPool(Instance.device, GlobalCommandPool, 0);
+            GlobalCommandPool = VK_NULL_HANDLE;
         }
     }
 }
 
 void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* Interfaces)
 {
-    SharedTexture_Init();
+    SharedTexture_InitLazy();
 
     UnityInterfaces = Interfaces;
     UnityGraphics = UNITY_GET_INTERFACE(UnityInterfaces, IUnityGraphics);
@@ -176,14 +307,32 @@ void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 unity_shared_texture UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateSharedTexture(const char *Name, int32_t Width, int32_t Height, uint32_t Format)
 {
     UnityVulkanInstance Instance = UnityVulkan->Instance();
+    if (!GlobalCommandPool)
+        UnityFuncs.vkCreateCommandPool(Instance.device,
+            &(VkCommandPoolCreateInfo) {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                .queueFamilyIndex = Instance.queueFamilyIndex,
+            },
+            0, &GlobalCommandPool
+        );
+
     shared_texture SharedTexture = SharedTexture_OpenOrCreate(Name, Width, Height, Format);
-    GlobalSharedTextures = realloc(GlobalSharedTextures, sizeof(vk_shared_texture*) * (++GlobalSharedTextureCount));
-    vk_shared_texture *VkSharedTexture = malloc(sizeof(vk_shared_texture));
-    *VkSharedTexture = SharedTexture_ToVulkan(SharedTexture, Instance.device, Instance.physicalDevice);
-    GlobalSharedTextures[GlobalSharedTextureCount-1] = VkSharedTexture;
+    unity_texture *Texture = calloc(1, sizeof(unity_texture));
+    Texture->SharedTexture = SharedTexture;
+    Texture->Vulkan = SharedTexture_ToVulkan(SharedTexture, Instance.device, Instance.physicalDevice);
+    VkImageMemoryBarrier Barrier = SharedTexture_VulkanRelease(SharedTexture, Texture->Vulkan, Instance.queueFamilyIndex, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    Barrier.srcAccessMask = 0;
+    Texture->Release = UnityHook_RecordBarrier(Barrier, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    if (!Texture->Release)
+    {
+        UnityHook_DestroyTexture(Texture);
+        return (unity_shared_texture) { 0 };
+    }
+    GlobalSharedTextures = realloc(GlobalSharedTextures, sizeof(unity_texture *) * (++GlobalSharedTextureCount));
+    GlobalSharedTextures[GlobalSharedTextureCount-1] = Texture;
 
     return (unity_shared_texture) {
-        .NativeTex = &VkSharedTexture->Image,
+        .NativeTex = &Texture->Vulkan.Image,
         .Format = SharedTexture.Format,
         .Width = SharedTexture.Width,
         .Height = SharedTexture.Height,
@@ -192,21 +341,18 @@ unity_shared_texture UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateSharedText
 
 void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API DestroySharedTexture(unity_shared_texture SharedTexture)
 {
-    UnityVulkanInstance Instance = UnityVulkan->Instance();
-    
     for (uint32_t i = 0; i < GlobalSharedTextureCount; ++i)
     {
-        if (GlobalSharedTextures[i]->Image != SharedTexture.NativeTex)
+        if (&GlobalSharedTextures[i]->Vulkan.Image != SharedTexture.NativeTex)
             continue;
 
-        SharedTexture_DestroyVulkanTexture(*GlobalSharedTextures[i], Instance.device);
-        free(GlobalSharedTextures[i]);
+        UnityHook_DestroyTexture(GlobalSharedTextures[i]);
 
         if (--GlobalSharedTextureCount)
         {
             for (uint32_t j = i; j < GlobalSharedTextureCount; ++j)
                 GlobalSharedTextures[j] = GlobalSharedTextures[j + 1];
-            GlobalSharedTextures = realloc(GlobalSharedTextures, sizeof(vk_shared_texture*) * (GlobalSharedTextureCount));
+            GlobalSharedTextures = realloc(GlobalSharedTextures, sizeof(unity_texture *) * (GlobalSharedTextureCount));
         }
         else
         {
@@ -8,9 +8,13 @@
 #if defined(_WIN32)
   #include <vulkan/vulkan_win32.h>
 #endif
+#include <string.h>
+
+typedef struct vk_device_funcs vk_device_funcs;
 
 static bool VK_LoadFunctions(void);
 static bool VK_LoadInstanceFunctions(VkInstance Instance);
+static bool VK_LoadDeviceFunctions(vk_device_funcs *Funcs, PFN_vkGetDeviceProcAddr GetDeviceProcAddr, VkDevice Device);
 static void VK_DeleteFunctions(void);
 
 //
@@ -21,16 +25,20 @@ static void VK_DeleteFunctions(void);
 
 /* 1.0 */
 VK_FUNC(vkGetInstanceProcAddr);
+VK_FUNC(vkGetDeviceProcAddr);
 VK_FUNC(vkCreateInstance);
 VK_FUNC(vkEnumerateInstanceExtensionProperties);
 VK_FUNC(vkEnumerateInstanceLayerProperties);
 VK_FUNC(vkDestroyInstance);
 VK_FUNC(vkEnumeratePhysicalDevices);
 VK_FUNC(vkGetPhysicalDeviceProperties);
+VK_FUNC(vkGetPhysicalDeviceProperties2);
 VK_FUNC(vkGetPhysicalDeviceFeatures);
 VK_FUNC(vkGetPhysicalDeviceQueueFamilyProperties);
 VK_FUNC(vkGetPhysicalDeviceMemoryProperties);
 VK_FUNC(vkGetPhysicalDeviceFormatProperties);
+VK_FUNC(vkGetPhysicalDeviceFormatProperties2);
+VK_FUNC(vkGetPhysicalDeviceImageFormatProperties2);
 VK_FUNC(vkCreateDevice);
 VK_FUNC(vkDestroyDevice);
 VK_FUNC(vkGetDeviceQueue);
@@ -51,6 +59,7 @@ VK_FUNC(vkCreateFramebuffer);
 VK_FUNC(vkDestroyFramebuffer);
 VK_FUNC(vkDestroyCommandPool);
 VK_FUNC(vkCreateCommandPool);
+VK_FUNC(vkResetCommandPool);
 VK_FUNC(vkAllocateCommandBuffers);
 VK_FUNC(vkFreeCommandBuffers);
 VK_FUNC(vkBeginCommandBuffer);
@@ -63,10 +72,13 @@ VK_FUNC(vkCmdBindVertexBuffers);
 VK_FUNC(vkCmdDraw);
 VK_FUNC(vkCmdEndRenderPass);
 VK_FUNC(vkCmdBlitImage);
+VK_FUNC(vkCmdCopyImage);
 VK_FUNC(vkCmdResolveImage);
 VK_FUNC(vkCmdCopyBuffer);
 VK_FUNC(vkCmdCopyBufferToImage);
+VK_FUNC(vkCmdCopyImageToBuffer);
 VK_FUNC(vkCmdPipelineBarrier);
+VK_FUNC(vkCmdPipelineBarrier2);
 VK_FUNC(vkCmdBindDescriptorSets);
 VK_FUNC(vkCmdPushConstants);
 VK_FUNC(vkCmdNextSubpass);
@@ -74,6 +86,8 @@ VK_FUNC(vkCmdSetViewport);
 VK_FUNC(vkCmdSetScissor);
 VK_FUNC(vkCreateSemaphore);
 VK_FUNC(vkDestroySemaphore);
+VK_FUNC(vkGetSemaphoreCounterValue);
+VK_FUNC(vkWaitSemaphores);
 VK_FUNC(vkCreateFence);
 VK_FUNC(vkDestroyFence);
 VK_FUNC(vkWaitForFences);
@@ -83,6 +97,8 @@ VK_FUNC(vkQueueWaitIdle);
 VK_FUNC(vkQueuePresentKHR);
 VK_FUNC(vkDeviceWaitIdle);
 VK_FUNC(vkGetImageMemoryRequirements);
+VK_FUNC(vkGetImageMemoryRequirements2);
+VK_FUNC(vkGetImageSubresourceLayout);
 VK_FUNC(vkGetBufferMemoryRequirements);
 VK_FUNC(vkGetDeviceImageMemoryRequirements);
 VK_FUNC(vkGetDeviceBufferMemoryRequirements);
@@ -94,6 +110,8 @@ VK_FUNC(vkCreateBuffer);
 VK_FUNC(vkDestroyBuffer);
 VK_FUNC(vkMapMemory);
 VK_FUNC(vkUnmapMemory);
+VK_FUNC(vkFlushMappedMemoryRanges);
+VK_FUNC(vkInvalidateMappedMemoryRanges);
 VK_FUNC(vkCreateDescriptorSetLayout);
 VK_FUNC(vkDestroyDescriptorSetLayout);
 VK_FUNC(vkCreateDescriptorPool);
@@ -103,6 +121,8 @@ VK_FUNC(vkFreeDescriptorSets);
 VK_FUNC(vkUpdateDescriptorSets);
 VK_FUNC(vkCreateSampler);
 VK_FUNC(vkDestroySampler);
+VK_FUNC(vkCreateSamplerYcbcrConversion);
+VK_FUNC(vkDestroySamplerYcbcrConversion);
 
 #if defined(_DEBUG)
 	VK_FUNC(vkCreateDebugReportCallbackEXT);
@@ -122,6 +142,9 @@ VK_FUNC(vkCreateSwapchainKHR);
 VK_FUNC(vkDestroySwapchainKHR);
 VK_FUNC(vkGetSwapchainImagesKHR);
 
+/* VK_EXT_external_memory_host */
+VK_FUNC(vkGetMemoryHostPointerPropertiesEXT);
+
 #if defined(_WIN32)
 	/* VK_KHR_external_memory_win32  */
 	VK_FUNC(vkGetMemoryWin32HandleKHR);
@@ -131,10 +154,138 @@ VK_FUNC(vkGetSwapchainImagesKHR);
 #else
 	/* VK_KHR_external_memory_fd */
 	VK_FUNC(vkGetMemoryFdKHR);
+	VK_FUNC(vkGetMemoryFdPropertiesKHR);
 	/* VK_KHR_external_semaphore_fd */
 	VK_FUNC(vkGetSemaphoreFdKHR);
+	VK_FUNC(vkImportSemaphoreFdKHR);
+	/* VK_EXT_image_drm_format_modifier */
+	VK_FUNC(vkGetImageDrmFormatModifierPropertiesEXT);
 #endif
 
+// Device level commands loaded through vkGetDeviceProcAddr, so they skip the
+// loader trampoline of the globals above. A table only works for the device it
+// was loaded for and its queues and command buffers. Newer core versions and
+// extensions stay NULL if the device does not have them.
+typedef struct vk_device_funcs
+{
+	VkDevice Device;
+	/* 1.0 */
+	VK_FUNC(vkDestroyDevice);
+	VK_FUNC(vkGetDeviceQueue);
+	VK_FUNC(vkDeviceWaitIdle);
+	VK_FUNC(vkQueueSubmit);
+	VK_FUNC(vkQueueWaitIdle);
+	VK_FUNC(vkCreateImage);
+	VK_FUNC(vkDestroyImage);
+	VK_FUNC(vkCreateImageView);
+	VK_FUNC(vkDestroyImageView);
+	VK_FUNC(vkCreateShaderModule);
+	VK_FUNC(vkDestroyShaderModule);
+	VK_FUNC(vkCreatePipelineLayout);
+	VK_FUNC(vkDestroyPipelineLayout);
+	VK_FUNC(vkCreateRenderPass);
+	VK_FUNC(vkDestroyRenderPass);
+	VK_FUNC(vkCreateGraphicsPipelines);
+	VK_FUNC(vkDestroyPipeline);
+	VK_FUNC(vkCreateFramebuffer);
+	VK_FUNC(vkDestroyFramebuffer);
+	VK_FUNC(vkDestroyCommandPool);
+	VK_FUNC(vkCreateCommandPool);
+	VK_FUNC(vkResetCommandPool);
+	VK_FUNC(vkAllocateCommandBuffers);
+	VK_FUNC(vkFreeCommandBuffers);
+	VK_FUNC(vkBeginCommandBuffer);
+	VK_FUNC(vkEndCommandBuffer);
+	VK_FUNC(vkResetCommandBuffer);
+	VK_FUNC(vkCmdExecuteCommands);
+	VK_FUNC(vkCmdBeginRenderPass);
+	VK_FUNC(vkCmdBindPipeline);
+	VK_FUNC(vkCmdBindVertexBuffers);
+	VK_FUNC(vkCmdDraw);
+	VK_FUNC(vkCmdEndRenderPass);
+	VK_FUNC(vkCmdBlitImage);
+	VK_FUNC(vkCmdCopyImage);
+	VK_FUNC(vkCmdResolveImage);
+	VK_FUNC(vkCmdCopyBuffer);
+	VK_FUNC(vkCmdCopyBufferToImage);
+	VK_FUNC(vkCmdCopyImageToBuffer);
+	VK_FUNC(vkCmdPipelineBarrier);
+	VK_FUNC(vkCmdBindDescriptorSets);
+	VK_FUNC(vkCmdPushConstants);
+	VK_FUNC(vkCmdNextSubpass);
+	VK_FUNC(vkCmdSetViewport);
+	VK_FUNC(vkCmdSetScissor);
+	VK_FUNC(vkCreateSemaphore);
+	VK_FUNC(vkDestroySemaphore);
+	VK_FUNC(vkCreateFence);
+	VK_FUNC(vkDestroyFence);
+	VK_FUNC(vkWaitForFences);
+	VK_FUNC(vkResetFences);
+	VK_FUNC(vkGetImageMemoryRequirements);
+	VK_FUNC(vkGetImageSubresourceLayout);
+	VK_FUNC(vkGetBufferMemoryRequirements);
+	VK_FUNC(vkAllocateMemory);
+	VK_FUNC(vkBindImageMemory);
+	VK_FUNC(vkBindBufferMemory);
+	VK_FUNC(vkFreeMemory);
+	VK_FUNC(vkCreateBuffer);
+	VK_FUNC(vkDestroyBuffer);
+	VK_FUNC(vkMapMemory);
+	VK_FUNC(vkUnmapMemory);
+	VK_FUNC(vkFlushMappedMemoryRanges);
+	VK_FUNC(vkInvalidateMappedMemoryRanges);
+	VK_FUNC(vkCreateDescriptorSetLayout);
+	VK_FUNC(vkDestroyDescriptorSetLayout);
+	VK_FUNC(vkCreateDescriptorPool);
+	VK_FUNC(vkDestroyDescriptorPool);
+	VK_FUNC(vkAllocateDescriptorSets);
+	VK_FUNC(vkFreeDescriptorSets);
+	VK_FUNC(vkUpdateDescriptorSets);
+	VK_FUNC(vkCreateSampler);
+	VK_FUNC(vkDestroySampler);
+
+	/* 1.1 */
+	VK_FUNC(vkGetImageMemoryRequirements2);
+	VK_FUNC(vkCreateSamplerYcbcrConversion);
+	VK_FUNC(vkDestroySamplerYcbcrConversion);
+
+	/* 1.2 */
+	VK_FUNC(vkGetSemaphoreCounterValue);
+	VK_FUNC(vkWaitSemaphores);
+
+	/* 1.3 */
+	VK_FUNC(vkCmdPipelineBarrier2);
+	VK_FUNC(vkGetDeviceImageMemoryRequirements);
+	VK_FUNC(vkGetDeviceBufferMemoryRequirements);
+
+	/* VK_KHR_swapchain */
+	VK_FUNC(vkAcquireNextImageKHR);
+	VK_FUNC(vkCreateSwapchainKHR);
+	VK_FUNC(vkDestroySwapchainKHR);
+	VK_FUNC(vkGetSwapchainImagesKHR);
+	VK_FUNC(vkQueuePresentKHR);
+
+	/* VK_EXT_external_memory_host */
+	VK_FUNC(vkGetMemoryHostPointerPropertiesEXT);
+
+#if defined(_WIN32)
+		/* VK_KHR_external_memory_win32 */
+		VK_FUNC(vkGetMemoryWin32HandleKHR);
+		/* VK_KHR_external_semaphore_win32 */
+		VK_FUNC(vkGetSemaphoreWin32HandleKHR);
+		VK_FUNC(vkImportSemaphoreWin32HandleKHR);
+#else
+		/* VK_KHR_external_memory_fd */
+		VK_FUNC(vkGetMemoryFdKHR);
+		VK_FUNC(vkGetMemoryFdPropertiesKHR);
+		/* VK_KHR_external_semaphore_fd */
+		VK_FUNC(vkGetSemaphoreFdKHR);
+		VK_FUNC(vkImportSemaphoreFdKHR);
+		/* VK_EXT_image_drm_format_modifier */
+		VK_FUNC(vkGetImageDrmFormatModifierPropertiesEXT);
+#endif
+} vk_device_funcs;
+
 #define VK_LOAD_FUNC(I, Name) Name = (PFN_##Name)vkGetInstanceProcAddr(I, #Name)
 #define VK_LOAD_AND_CHECK(I, Name) Name = (PFN_##Name)vkGetInstanceProcAddr(I, #Name); if(!Name) return false;
 
@@ -150,13 +301,17 @@ static bool VK_LoadFunctions(void)
 static bool VK_LoadInstanceFunctions(VkInstance Instance)
 {
 	/* 1.0 */
+	VK_LOAD_AND_CHECK(Instance, vkGetDeviceProcAddr);
 	VK_LOAD_AND_CHECK(Instance, vkDestroyInstance);
 	VK_LOAD_AND_CHECK(Instance, vkEnumeratePhysicalDevices);
 	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceProperties);
+	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceProperties2);
 	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceFeatures);
 	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceQueueFamilyProperties);
 	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceMemoryProperties);
 	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceFormatProperties);
+	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceFormatProperties2);
+	VK_LOAD_AND_CHECK(Instance, vkGetPhysicalDeviceImageFormatProperties2);
 	VK_LOAD_AND_CHECK(Instance, vkCreateDevice);
 	VK_LOAD_AND_CHECK(Instance, vkDestroyDevice);
 	VK_LOAD_AND_CHECK(Instance, vkGetDeviceQueue);
@@ -177,6 +332,7 @@ static bool VK_LoadInstanceFunctions(VkInstance Instance)
 	VK_LOAD_AND_CHECK(Instance, vkDestroyFramebuffer);
 	VK_LOAD_AND_CHECK(Instance, vkDestroyCommandPool);
 	VK_LOAD_AND_CHECK(Instance, vkCreateCommandPool);
+	VK_LOAD_AND_CHECK(Instance, vkResetCommandPool);
 	VK_LOAD_AND_CHECK(Instance, vkAllocateCommandBuffers);
 	VK_LOAD_AND_CHECK(Instance, vkFreeCommandBuffers);
 	VK_LOAD_AND_CHECK(Instance, vkBeginCommandBuffer);
@@ -189,10 +345,13 @@ static bool VK_LoadInstanceFunctions(VkInstance Instance)
 	VK_LOAD_AND_CHECK(Instance, vkCmdDraw);
 	VK_LOAD_AND_CHECK(Instance, vkCmdEndRenderPass);
 	VK_LOAD_AND_CHECK(Instance, vkCmdBlitImage);
+	VK_LOAD_AND_CHECK(Instance, vkCmdCopyImage);
 	VK_LOAD_AND_CHECK(Instance, vkCmdResolveImage);
 	VK_LOAD_AND_CHECK(Instance, vkCmdCopyBuffer);
 	VK_LOAD_AND_CHECK(Instance, vkCmdCopyBufferToImage);
+	VK_LOAD_AND_CHECK(Instance, vkCmdCopyImageToBuffer);
 	VK_LOAD_AND_CHECK(Instance, vkCmdPipelineBarrier);
+	VK_LOAD_AND_CHECK(Instance, vkCmdPipelineBarrier2);
 	VK_LOAD_AND_CHECK(Instance, vkCmdBindDescriptorSets);
 	VK_LOAD_AND_CHECK(Instance, vkCmdPushConstants);
 	VK_LOAD_AND_CHECK(Instance, vkCmdNextSubpass);
@@ -200,6 +359,8 @@ static bool VK_LoadInstanceFunctions(VkInstance Instance)
 	VK_LOAD_AND_CHECK(Instance, vkCmdSetScissor);
 	VK_LOAD_AND_CHECK(Instance, vkCreateSemaphore);
 	VK_LOAD_AND_CHECK(Instance, vkDestroySemaphore);
+	VK_LOAD_AND_CHECK(Instance, vkGetSemaphoreCounterValue);
+	VK_LOAD_AND_CHECK(Instance, vkWaitSemaphores);
 	VK_LOAD_AND_CHECK(Instance, vkCreateFence);
 	VK_LOAD_AND_CHECK(Instance, vkDestroyFence);
 	VK_LOAD_AND_CHECK(Instance, vkWaitForFences);
@@ -209,6 +370,8 @@ static bool VK_LoadInstanceFunctions(VkInstance Instance)
 	VK_LOAD_AND_CHECK(Instance, vkQueuePresentKHR);
 	VK_LOAD_AND_CHECK(Instance, vkDeviceWaitIdle);
 	VK_LOAD_AND_CHECK(Instance, vkGetImageMemoryRequirements);
+	VK_LOAD_AND_CHECK(Instance, vkGetImageMemoryRequirements2);
+	VK_LOAD_AND_CHECK(Instance, vkGetImageSubresourceLayout);
 	VK_LOAD_AND_CHECK(Instance, vkGetBufferMemoryRequirements);
 	VK_LOAD_AND_CHECK(Instance, vkGetDeviceImageMemoryRequirements);
 	VK_LOAD_AND_CHECK(Instance, vkGetDeviceBufferMemoryRequirements);
@@ -220,6 +383,8 @@ static bool VK_LoadInstanceFunctions(VkInstance Instance)
 	VK_LOAD_AND_CHECK(Instance, vkDestroyBuffer);
 	VK_LOAD_AND_CHECK(Instance, vkMapMemory);
 	VK_LOAD_AND_CHECK(Instance, vkUnmapMemory);
+	VK_LOAD_AND_CHECK(Instance, vkFlushMappedMemoryRanges);
+	VK_LOAD_AND_CHECK(Instance, vkInvalidateMappedMemoryRanges);
 	VK_LOAD_AND_CHECK(Instance, vkCreateDescriptorSetLayout);
 	VK_LOAD_AND_CHECK(Instance, vkDestroyDescriptorSetLayout);
 	VK_LOAD_AND_CHECK(Instance, vkCreateDescriptorPool);
@@ -229,6 +394,8 @@ static bool VK_LoadInstanceFunctions(VkInstance Instance)
 	VK_LOAD_AND_CHECK(Instance, vkUpdateDescriptorSets);
 	VK_LOAD_AND_CHECK(Instance, vkCreateSampler);
 	VK_LOAD_AND_CHECK(Instance, vkDestroySampler);
+	VK_LOAD_AND_CHECK(Instance, vkCreateSamplerYcbcrConversion);
+	VK_LOAD_AND_CHECK(Instance, vkDestroySamplerYcbcrConversion);
 
 #if defined(_DEBUG)
 	VK_LOAD_FUNC(Instance, vkCreateDebugReportCallbackEXT);
@@ -248,6 +415,9 @@ VK_LOAD_FUNC(Instance, vkCreateSwapchainKHR);
 VK_LOAD_FUNC(Instance, vkDestroySwapchainKHR);
 VK_LOAD_FUNC(Instance, vkGetSwapchainImagesKHR);
 
+/* VK_EXT_external_memory_host */
+VK_LOAD_FUNC(Instance, vkGetMemoryHostPointerPropertiesEXT);
+
 #if defined(_WIN32)
 	/* VK_KHR_external_memory_win32  */
 	VK_LOAD_FUNC(Instance, vkGetMemoryWin32HandleKHR);
@@ -257,8 +427,144 @@ VK_LOAD_FUNC(Instance, vkGetSwapchainImagesKHR);
 #else
 	/* VK_KHR_external_memory_fd */
 	VK_LOAD_FUNC(Instance, vkGetMemoryFdKHR);
+	VK_LOAD_FUNC(Instance, vkGetMemoryFdPropertiesKHR);
 	/* VK_KHR_external_semaphore_fd */
 	VK_LOAD_FUNC(Instance, vkGetSemaphoreFdKHR);
+	VK_LOAD_FUNC(Instance, vkImportSemaphoreFdKHR);
+	/* VK_EXT_image_drm_format_modifier */
+	VK_LOAD_FUNC(Instance, vkGetImageDrmFormatModifierPropertiesEXT);
+#endif
+
+	return true;
+}
+
+#define VK_LOAD_DEVICE_FUNC(D, Name) Funcs->Name = (PFN_##Name)GetDeviceProcAddr(D, #Name)
+#define VK_LOAD_DEVICE_AND_CHECK(D, Name) Funcs->Name = (PFN_##Name)GetDeviceProcAddr(D, #Name); if(!Funcs->Name) return false;
+
+// GetDeviceProcAddr may be NULL to use the one of the instance loaded last.
+static bool VK_LoadDeviceFunctions(vk_device_funcs *Funcs, PFN_vkGetDeviceProcAddr GetDeviceProcAddr, VkDevice Device)
+{
+	memset(Funcs, 0, sizeof(vk_device_funcs));
+	if (!GetDeviceProcAddr)
+		GetDeviceProcAddr = vkGetDeviceProcAddr;
+	if (!GetDeviceProcAddr || Device == VK_NULL_HANDLE)
+		return false;
+	Funcs->Device = Device;
+
+	/* 1.0 */
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyDevice);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkGetDeviceQueue);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDeviceWaitIdle);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkQueueSubmit);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkQueueWaitIdle);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateImage);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyImage);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateImageView);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyImageView);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateShaderModule);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyShaderModule);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreatePipelineLayout);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyPipelineLayout);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateRenderPass);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyRenderPass);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateGraphicsPipelines);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyPipeline);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateFramebuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyFramebuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyCommandPool);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateCommandPool);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkResetCommandPool);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkAllocateCommandBuffers);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkFreeCommandBuffers);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkBeginCommandBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkEndCommandBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkResetCommandBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdExecuteCommands);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdBeginRenderPass);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdBindPipeline);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdBindVertexBuffers);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdDraw);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdEndRenderPass);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdBlitImage);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdCopyImage);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdResolveImage);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdCopyBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdCopyBufferToImage);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdCopyImageToBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdPipelineBarrier);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdBindDescriptorSets);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdPushConstants);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdNextSubpass);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdSetViewport);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCmdSetScissor);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateSemaphore);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroySemaphore);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateFence);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyFence);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkWaitForFences);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkResetFences);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkGetImageMemoryRequirements);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkGetImageSubresourceLayout);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkGetBufferMemoryRequirements);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkAllocateMemory);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkBindImageMemory);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkBindBufferMemory);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkFreeMemory);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyBuffer);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkMapMemory);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkUnmapMemory);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkFlushMappedMemoryRanges);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkInvalidateMappedMemoryRanges);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateDescriptorSetLayout);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyDescriptorSetLayout);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateDescriptorPool);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroyDescriptorPool);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkAllocateDescriptorSets);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkFreeDescriptorSets);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkUpdateDescriptorSets);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkCreateSampler);
+	VK_LOAD_DEVICE_AND_CHECK(Device, vkDestroySampler);
+
+	/* 1.1 */
+	VK_LOAD_DEVICE_FUNC(Device, vkGetImageMemoryRequirements2);
+	VK_LOAD_DEVICE_FUNC(Device, vkCreateSamplerYcbcrConversion);
+	VK_LOAD_DEVICE_FUNC(Device, vkDestroySamplerYcbcrConversion);
+
+	/* 1.2 */
+	VK_LOAD_DEVICE_FUNC(Device, vkGetSemaphoreCounterValue);
+	VK_LOAD_DEVICE_FUNC(Device, vkWaitSemaphores);
+
+	/* 1.3 */
+	VK_LOAD_DEVICE_FUNC(Device, vkCmdPipelineBarrier2);
+	VK_LOAD_DEVICE_FUNC(Device, vkGetDeviceImageMemoryRequirements);
+	VK_LOAD_DEVICE_FUNC(Device, vkGetDeviceBufferMemoryRequirements);
+
+	/* VK_KHR_swapchain */
+	VK_LOAD_DEVICE_FUNC(Device, vkAcquireNextImageKHR);
+	VK_LOAD_DEVICE_FUNC(Device, vkCreateSwapchainKHR);
+	VK_LOAD_DEVICE_FUNC(Device, vkDestroySwapchainKHR);
+	VK_LOAD_DEVICE_FUNC(Device, vkGetSwapchainImagesKHR);
+	VK_LOAD_DEVICE_FUNC(Device, vkQueuePresentKHR);
+
+	/* VK_EXT_external_memory_host */
+	VK_LOAD_DEVICE_FUNC(Device, vkGetMemoryHostPointerPropertiesEXT);
+
+#if defined(_WIN32)
+		/* VK_KHR_external_memory_win32 */
+		VK_LOAD_DEVICE_FUNC(Device, vkGetMemoryWin32HandleKHR);
+		/* VK_KHR_external_semaphore_win32 */
+		VK_LOAD_DEVICE_FUNC(Device, vkGetSemaphoreWin32HandleKHR);
+		VK_LOAD_DEVICE_FUNC(Device, vkImportSemaphoreWin32HandleKHR);
+#else
+		/* VK_KHR_external_memory_fd */
+		VK_LOAD_DEVICE_FUNC(Device, vkGetMemoryFdKHR);
+		VK_LOAD_DEVICE_FUNC(Device, vkGetMemoryFdPropertiesKHR);
+		/* VK_KHR_external_semaphore_fd */
+		VK_LOAD_DEVICE_FUNC(Device, vkGetSemaphoreFdKHR);
+		VK_LOAD_DEVICE_FUNC(Device, vkImportSemaphoreFdKHR);
+		/* VK_EXT_image_drm_format_modifier */
+		VK_LOAD_DEVICE_FUNC(Device, vkGetImageDrmFormatModifierPropertiesEXT);
 #endif
 
 	return true;
@@ -267,13 +573,17 @@ VK_LOAD_FUNC(Instance, vkGetSwapchainImagesKHR);
 static void VK_DeleteFunctions(void)
 {
 	/* 1.0 */
+	vkGetDeviceProcAddr = 0;
 	vkDestroyInstance = 0;
 	vkEnumeratePhysicalDevices = 0;
 	vkGetPhysicalDeviceProperties = 0;
+	vkGetPhysicalDeviceProperties2 = 0;
 	vkGetPhysicalDeviceFeatures = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties = 0;
 	vkGetPhysicalDeviceMemoryProperties = 0;
 	vkGetPhysicalDeviceFormatProperties = 0;
+	vkGetPhysicalDeviceFormatProperties2 = 0;
+	vkGetPhysicalDeviceImageFormatProperties2 = 0;
 	vkCreateDevice = 0;
 	vkDestroyDevice = 0;
 	vkGetDeviceQueue = 0;
@@ -286,6 +596,8 @@ static void VK_DeleteFunctions(void)
 	vkCreateSwapchainKHR = 0;
 	vkDestroySwapchainKHR = 0;
 	vkGetSwapchainImagesKHR = 0;
+
+vkGetMemoryHostPointerPropertiesEXT = 0;
 	vkAcquireNextImageKHR = 0;
 	vkCreateImage = 0;
 	vkDestroyImage = 0;
@@ -303,6 +615,7 @@ static void VK_DeleteFunctions(void)
 	vkDestroyFramebuffer = 0;
 	vkDestroyCommandPool = 0;
 	vkCreateCommandPool = 0;
+	vkResetCommandPool = 0;
 	vkAllocateCommandBuffers = 0;
 	vkFreeCommandBuffers = 0;
 	vkBeginCommandBuffer = 0;
@@ -315,10 +628,13 @@ static void VK_DeleteFunctions(void)
 	vkCmdDraw = 0;
 	vkCmdEndRenderPass = 0;
 	vkCmdBlitImage = 0;
+	vkCmdCopyImage = 0;
 	vkCmdResolveImage = 0;
 	vkCmdCopyBuffer = 0;
 	vkCmdCopyBufferToImage = 0;
+	vkCmdCopyImageToBuffer = 0;
 	vkCmdPipelineBarrier = 0;
+	vkCmdPipelineBarrier2 = 0;
 	vkCmdBindDescriptorSets = 0;
 	vkCmdPushConstants = 0;
 	vkCmdNextSubpass = 0;
@@ -326,6 +642,8 @@ static void VK_DeleteFunctions(void)
 	vkCmdSetScissor = 0;
 	vkCreateSemaphore = 0;
 	vkDestroySemaphore = 0;
+	vkGetSemaphoreCounterValue = 0;
+	vkWaitSemaphores = 0;
 	vkCreateFence = 0;
 	vkDestroyFence = 0;
 	vkWaitForFences = 0;
@@ -335,6 +653,8 @@ static void VK_DeleteFunctions(void)
 	vkQueuePresentKHR = 0;
 	vkDeviceWaitIdle = 0;
 	vkGetImageMemoryRequirements = 0;
+	vkGetImageMemoryRequirements2 = 0;
+	vkGetImageSubresourceLayout = 0;
 	vkGetBufferMemoryRequirements = 0;
 	vkGetDeviceImageMemoryRequirements = 0;
 	vkGetDeviceBufferMemoryRequirements = 0;
@@ -346,6 +666,8 @@ static void VK_DeleteFunctions(void)
 	vkDestroyBuffer = 0;
 	vkMapMemory = 0;
 	vkUnmapMemory = 0;
+	vkFlushMappedMemoryRanges = 0;
+	vkInvalidateMappedMemoryRanges = 0;
 	vkCreateDescriptorSetLayout = 0;
 	vkDestroyDescriptorSetLayout = 0;
 	vkCreateDescriptorPool = 0;
@@ -355,6 +677,8 @@ static void VK_DeleteFunctions(void)
 	vkUpdateDescriptorSets = 0;
 	vkCreateSampler = 0;
 	vkDestroySampler = 0;
+	vkCreateSamplerYcbcrConversion = 0;
+	vkDestroySamplerYcbcrConversion = 0;
 
 #if defined(_DEBUG)
 	vkCreateDebugReportCallbackEXT = 0;
@@ -378,9 +702,14 @@ vkGetSwapchainImagesKHR = 0;
 	vkImportSemaphoreWin32HandleKHR = 0;
 #else
 	vkGetMemoryFdKHR = 0;
+	vkGetMemoryFdPropertiesKHR = 0;
 	vkGetSemaphoreFdKHR = 0;
+	vkImportSemaphoreFdKHR = 0;
+	vkGetImageDrmFormatModifierPropertiesEXT = 0;
 #endif
 }
 
 #undef VK_FUNC
 #undef VK_LOAD_AND_CHECK
+#undef VK_LOAD_DEVICE_FUNC
+#undef VK_LOAD_DEVICE_AND_CHECK